@@ -3,24 +3,77 @@
  */
 
 #include "HashTable.h"
-#include <random>
+#include "HashTableMapped.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
 
 /**
  *	Returns `true` if and only if `key` matches the bucket's key and that bucket is nonempty.
+ *	The stored hash code is compared first, so the key bytes of a bucket are only
+ *	read when its hash code equals `keyHash`, the hash code of `key`.
  */
-bool normalAndEqual(const HashTableBucket &bucket, const std::string &key) {
-	return (bucket.getKey() == key) && !bucket.isEmpty();
+bool normalAndEqual(const HashTableBucket &bucket, std::string_view key, size_t keyHash) {
+	return !bucket.isEmpty() && bucket.getHash() == keyHash && (bucket.getKey() == key);
 }
 
 /**
  *	The internal capacity of the hash table is set to the initial
- *	capacity, if specified. Default is 8.
+ *	capacity, if specified. Default is 8. The indexing strategy rounds
+ *	it up to a valid capacity, e.g. the next power of two.
+ *
+ *	The buckets and the arena chunks holding long keys are allocated from
+ *	`resource`, the default memory resource unless specified.
+ *
+ *	With a seeded `Hash`, every table gets a new random seed, which also
+ *	seeds the probing strategy if it draws random numbers.
  */
-HashTable::HashTable(size_t initCapacity) {
+HashTable::HashTable(size_t initCapacity, std::pmr::memory_resource *resource)
+	: HashTable(initCapacity, Hash(), resource) {}
+
+/** Like the public constructor, but hashes keys with `hasher`, and with its seed if it has one. */
+HashTable::HashTable(size_t initCapacity, const Hash &hasher, std::pmr::memory_resource *resource)
+	: hasher(hasher), tableData(resource), keyArena(resource) {
+	initCapacity = Indexing::roundCapacity(initCapacity);
+
 	this->length = 0;
-	this->generate_permutation(initCapacity);
-	this->tableData = std::vector<HashTableBucket>(initCapacity);
+	this->tombstones = 0;
+	this->removedKeyBytes = 0;
+	if (Hash::seeded) {seedProbing(this->probing, this->hasher.seed());}
+	this->indexing.reset(initCapacity);
+	this->probing.reset(initCapacity);
+	this->tableData.resize(initCapacity);
+}
+
+/**
+ *	Copies every setting and bucket of another table into memory from
+ *	`resource`. Keys that live in the other table's arena are copied into
+ *	this table's own arena. The copy keeps the hash seed of the other table,
+ *	since the buckets hold hash codes computed with it.
+ */
+HashTable::HashTable(const HashTable &other, std::pmr::memory_resource *resource)
+	: indexing(other.indexing), probing(other.probing), growth(other.growth), hasher(other.hasher), tableData(other.tableData, resource),
+	keyArena(resource), length(other.length), tombstones(other.tombstones), removedKeyBytes(0) {
+	for (HashTableBucket &bucket : this->tableData) {
+		if (!bucket.isEmpty()) {bucket.load(bucket.getKey(), bucket.valueOf(), bucket.getHash(), this->keyArena);}
+	}
+}
+
+/**
+ *	Copies another table into this one. The copy is built on this table's
+ *	memory resource, so the table keeps the resource it was constructed
+ *	with, and the move into place then takes over its buckets and arena.
+ */
+HashTable & HashTable::operator=(const HashTable &other) {
+	if (this != &other) {*this = HashTable(other, this->tableData.get_allocator().resource());}
+	return *this;
 }
 
 /**
@@ -30,6 +83,148 @@ double HashTable::alpha() const {
 	return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
 }
 
+/**
+ *	Returns the number of `EAR` buckets, which still lengthen probe sequences.
+ */
+size_t HashTable::tombstoneCount() const {
+	return this->tombstones;
+}
+
+/**
+ *	Removes every key-value pair but keeps the capacity. The arena chunks
+ *	holding long keys are freed all at once, instead of one key at a time.
+ */
+void HashTable::clear() {
+	for (HashTableBucket &bucket : this->tableData) {bucket.makeESS();}
+	this->keyArena.clear();
+	this->length = 0;
+	this->tombstones = 0;
+	this->removedKeyBytes = 0;
+}
+
+/**
+ *	Returns the number of bytes the arena holds for keys too long to be
+ *	stored inline, including the unused tail of its last chunk. Removed keys
+ *	are reclaimed by `resize`, which `remove` calls once they take more of
+ *	the arena than the live keys do, so this stays proportional to the live
+ *	keys and the capacity.
+ */
+size_t HashTable::arenaBytes() const {
+	return this->keyArena.bytesReserved();
+}
+
+/** Returns the bytes a probing strategy allocates, which only `PermutationProbing` does for its offsets. */
+template<typename Strategy>
+size_t probingBytes(const Strategy &probing) {
+	if constexpr (requires {probing.offsets;}) {return probing.offsets.capacity() * sizeof(size_t);}
+	else {return 0;}
+}
+
+/**
+ *	Returns occupancy, probe-length, cluster and memory statistics, see
+ *	`HashTableStats`. The table is scanned once, and every key is probed for
+ *	by its stored hash code, so this takes `O(n)` plus the probes of every
+ *	key; it is meant for monitoring, not for every operation.
+ */
+HashTableStats HashTable::stats() const {
+	HashTableStats stats;
+	stats.capacity = this->capacity();
+	stats.size = this->size();
+	stats.tombstones = this->tombstones;
+	stats.empty = this->capacity() - this->size() - this->tombstones;
+	stats.loadFactor = this->alpha();
+
+	// A key's probe length is the number of probes until its own bucket.
+	for (size_t bucketIndex = 0; bucketIndex < this->capacity(); ++bucketIndex) {
+		const HashTableBucket &bucket = this->tableData[bucketIndex];
+		if (bucket.isEmpty()) {continue;}
+		ProbeCursor probe = this->probing.begin(bucket.getHash(), this->indexing);
+		while (probe.index != bucketIndex) {this->probing.advance(probe, this->indexing);}
+		stats.hitProbes.add(probe.probe + 1);
+	}
+
+	// A missing key probes until the first `ESS` bucket; random hash codes stand in for missing keys.
+	std::mt19937_64 random(0);
+	for (size_t sample = 0; sample < HashTableStats::MISS_SAMPLES; ++sample) {
+		ProbeCursor probe = this->probing.begin(static_cast<size_t>(random()), this->indexing);
+		while (!this->tableData[probe.index].isEmptySinceStart()) {this->probing.advance(probe, this->indexing);}
+		stats.missProbes.add(probe.probe + 1);
+	}
+
+	// Clusters are counted from an `ESS` bucket on, so one wrapping around the end is counted once.
+	size_t first = 0;
+	while (first < this->capacity() && !this->tableData[first].isEmptySinceStart()) {++first;}
+	size_t run = 0;
+	for (size_t offset = 1; offset <= this->capacity(); ++offset) {
+		const size_t bucketIndex = (first + offset) % this->capacity();
+		if (!this->tableData[bucketIndex].isEmptySinceStart()) {++run;}
+		else if (run > 0) {stats.clusters.add(run); run = 0;}
+	}
+
+	stats.hitProbes.summarize();
+	stats.missProbes.summarize();
+	stats.clusters.summarize();
+
+#ifdef HASHTABLE_STATS
+	stats.resizes = this->resizeCount;
+	stats.resizeSeconds = this->resizeSeconds;
+#endif
+
+	stats.bucketBytes = this->capacity() * sizeof(HashTableBucket);
+	stats.keyArenaBytes = this->keyArena.bytesReserved();
+	stats.keyArenaUsedBytes = this->keyArena.bytesUsed();
+	stats.probingBytes = probingBytes(this->probing);
+	return stats;
+}
+
+/**
+ *	Returns the load factor at which the table grows. Default is 0.5.
+ */
+double HashTable::max_load_factor() const {
+	return this->growth.maxLoadFactor;
+}
+
+/**
+ *	Sets the load factor at which the table grows, which must lie in `(0, 1)`.
+ *	If the table is already past it, the table is rehashed right away.
+ */
+void HashTable::max_load_factor(double maxLoadFactor) {
+	this->growth.setMaxLoadFactor(maxLoadFactor);
+	if (this->growth.exceeds(this->size(), this->capacity())) {this->rehash(0);}
+}
+
+/**
+ *	Returns the factor the capacity is multiplied by when the table grows.
+ *	Default is 2.
+ */
+double HashTable::growth_factor() const {
+	return this->growth.growthFactor;
+}
+
+/**
+ *	Sets the factor the capacity is multiplied by when the table grows,
+ *	which must be greater than 1.
+ */
+void HashTable::growth_factor(double growthFactor) {
+	this->growth.setGrowthFactor(growthFactor);
+}
+
+/**
+ *	Makes room for `count` entries, so inserting up to `count` keys does a
+ *	single allocation here and no resize afterwards.
+ */
+void HashTable::reserve(size_t count) {
+	if (this->growth.bucketsFor(count) > this->capacity()) {this->resize(this->growth.bucketsFor(count));}
+}
+
+/**
+ *	Rebuilds the table with at least `count` buckets, and at least enough to
+ *	keep the current entries below the max load factor.
+ */
+void HashTable::rehash(size_t count) {
+	this->resize(std::max(count, this->growth.bucketsFor(this->size())));
+}
+
 /**
  *	Returns the number of buckets in the hash table.
  */
@@ -45,85 +240,221 @@ size_t HashTable::size() const {
 }
 
 /**
- *	Generates a vector of offsets using random number generation.
+ *	@brief Inserts a new key-value pair into the table.
+ *
+ *	Returns `true` if a unique key is inserted. Also `size` is increased.
  *
- *	Index `0` of the offsets vector is always `0`, and other indices
- *	starting at `1` are shuffled in-place.
+ *	Returns `false` if a duplicate key is attempted to be inserted.
+ *
+ *	The hash code is determined using the key. The probing strategy maps it
+ *	to the bucket number in probe index `0`. If a probed bucket is occupied
+ *	but the keys themselves are not equal, increment the probe sequence index
+ *	until an `EAR` or `ESS` bucket is reached.
+ *
+ *	The time complexity is bounded to `O(1) <= T <= O(n)`.
  */
-void HashTable::generate_permutation(const size_t length) {
-	std::mt19937_64 s;
-	std::vector<size_t> offsets(length);
+bool HashTable::insert(std::string_view key, const size_t &value) {
+	return this->insert(key, this->hasher(key), value);
+}
 
-	// Each element in the offsets vector starts with the indices themselves.
-	for (size_t i = 0; i < offsets.size(); ++i) {offsets[i] = i;}
+/** Like `insert`, with the hash code of `key` already computed. */
+bool HashTable::insert(std::string_view key, size_t keyHash, const size_t &value) {
+	const auto [bucket, inserted] = this->findOrInsert(key, keyHash, value);
+	if (!inserted) {bucket->valueOf() = value;}
+	return inserted;
+}
 
-	// Then shuffle each element starting at index 1 with another element starting at index 1.
-	// Shuffling size - 1 elements.
-	for (size_t i = 1; i < offsets.size(); ++i) {
-		size_t randomOffset, indexToSwap, temp;
+/** Runs `task(t)` for every `t < tasks`, each on its own thread, the first one on the calling thread. */
+template<typename Task>
+void parallelFor(size_t tasks, Task task) {
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < tasks; ++t) {workers.emplace_back(task, t);}
+	task(0);
+	for (std::thread &worker : workers) {worker.join();}
+}
 
-		// Generate an integer between 1 to size - 2.
-		// Offset cannot be 0 for a true swap under a subvector of length (size - 1).
-		randomOffset = 1 + s() % (offsets.size() - 2);
+/**
+ *	@brief Inserts every key-value pair of `entries`, with the same result as
+ *		calling `insert` on each pair in order, and returns the number of new
+ *		keys.
+ *
+ *	If `inserted` is not empty, it must hold one entry per pair and receives
+ *	what `insert` would have returned for that pair: `false` if the key was
+ *	already in the table or appeared earlier in `entries`. A repeated key
+ *	keeps the value of its last pair.
+ *
+ *	From `PARALLEL_INSERT_THRESHOLD` pairs on, the pairs are inserted by
+ *	`threads` threads, or one per core if `threads` is `0`.
+ *
+ *	The table is sized once for every pair being new. The keys are hashed in
+ *	parallel and partitioned by the range of buckets their home bucket lies
+ *	in, and each range is filled by one thread without locks: a probe that
+ *	would leave its range is deferred instead. Every pair of a key shares its
+ *	home bucket, so the pairs of one key stay in order within their range.
+ *	The deferred pairs are inserted one by one at the end.
+ *
+ *	The time complexity is bounded to `O(k) <= T <= O(k * n)` for `k` pairs.
+ */
+size_t HashTable::insert_range(std::span<const std::pair<std::string_view, size_t>> entries, std::span<bool> inserted, size_t threads) {
+	if (!inserted.empty() && inserted.size() < entries.size()) {throw std::invalid_argument("insert_range needs one result per pair");}
+	if (entries.empty()) {return 0;}
+
+	// Without `EAR` buckets, a range is filled by placing each new key in the first `ESS` bucket.
+	const size_t newCapacity = std::max(this->capacity(), this->growth.bucketsFor(this->size() + entries.size()));
+	if (newCapacity > this->capacity() || this->tombstones > 0) {this->resize(newCapacity);}
+
+	// More ranges than threads keep every thread busy when some ranges take longer.
+	if (entries.size() < PARALLEL_INSERT_THRESHOLD) {threads = 1;}
+	else if (threads == 0) {threads = std::max(1u, std::thread::hardware_concurrency());}
+	const size_t ranges = (threads == 1) ? 1 : 8 * threads;
+	const size_t rangeSize = (this->capacity() + ranges - 1) / ranges;
+	auto rangeOf = [this, rangeSize](size_t keyHash) {return this->probing.begin(keyHash, this->indexing).index / rangeSize;};
+	auto sliceOf = [&entries, threads](size_t t) {return std::pair(entries.size() * t / threads, entries.size() * (t + 1) / threads);};
+
+	// Each thread hashes a slice of the pairs and counts them per range.
+	std::vector<size_t> hashes(entries.size());
+	std::vector<std::vector<size_t>> offsets(threads, std::vector<size_t>(ranges, 0));
+	parallelFor(threads, [&](size_t t) {
+		const auto [first, last] = sliceOf(t);
+		for (size_t i = first; i < last; ++i) {
+			hashes[i] = this->hasher(entries[i].first);
+			++offsets[t][rangeOf(hashes[i])];
+		}
+	});
+
+	// Pairs are ordered by range, then by slice, so each range keeps the input order.
+	std::vector<size_t> rangeStarts(ranges + 1, 0);
+	for (size_t range = 0, position = 0; range < ranges; ++range) {
+		rangeStarts[range] = position;
+		for (size_t t = 0; t < threads; ++t) {position += std::exchange(offsets[t][range], position);}
+		rangeStarts[range + 1] = position;
+	}
 
-		// Resolve to an index between 1 to size - 1.
-		indexToSwap = 1 + (i + randomOffset - 1) % (offsets.size() - 1);
+	std::vector<size_t> order(entries.size());
+	parallelFor(threads, [&](size_t t) {
+		const auto [first, last] = sliceOf(t);
+		for (size_t i = first; i < last; ++i) {order[offsets[t][rangeOf(hashes[i])]++] = i;}
+	});
+
+	// Long keys go to one arena per thread, merged into the table's arena afterwards.
+	std::vector<StringArena> arenas;
+	for (size_t t = 0; t < threads; ++t) {arenas.emplace_back(this->tableData.get_allocator().resource());}
+	std::vector<size_t> added(threads, 0);
+	std::vector<std::vector<size_t>> deferred(threads);
+	std::atomic<size_t> nextRange = 0;
+
+	parallelFor(threads, [&](size_t t) {
+		for (size_t range = nextRange++; range < ranges; range = nextRange++) {
+			const size_t rangeBegin = range * rangeSize, rangeEnd = rangeBegin + rangeSize;
+			for (size_t position = rangeStarts[range]; position < rangeStarts[range + 1]; ++position) {
+				const size_t i = order[position];
+				const auto &[key, value] = entries[i];
+
+				ProbeCursor probe = this->probing.begin(hashes[i], this->indexing);
+				while (true) {
+					if (probe.index < rangeBegin || probe.index >= rangeEnd) {deferred[t].push_back(i); break;}
+					HashTableBucket &bucket = this->tableData[probe.index];
+					if (normalAndEqual(bucket, key, hashes[i])) {
+						bucket.valueOf() = value;
+						if (!inserted.empty()) {inserted[i] = false;}
+						break;
+					} else if (bucket.isEmptySinceStart()) {
+						bucket.load(key, value, hashes[i], arenas[t]);
+						if (!inserted.empty()) {inserted[i] = true;}
+						++added[t];
+						break;
+					} else {this->probing.advance(probe, this->indexing); continue;}
+				}
+			}
+		}
+	});
 
-		// Then swap the elements between the two indices.
-		temp = offsets[indexToSwap];
-		offsets[indexToSwap] = offsets[i];
-		offsets[i] = temp;
+	size_t newKeys = 0;
+	for (size_t t = 0; t < threads; ++t) {
+		newKeys += added[t];
+		this->keyArena.adopt(std::move(arenas[t]));
 	}
-
-	this->offsets = offsets;
+	this->length += newKeys;
+
+	std::vector<size_t> remaining;
+	for (const std::vector<size_t> &pairs : deferred) {remaining.insert(remaining.end(), pairs.begin(), pairs.end());}
+	std::sort(remaining.begin(), remaining.end());
+	for (const size_t i : remaining) {
+		const bool isNew = this->insert(entries[i].first, entries[i].second);
+		if (!inserted.empty()) {inserted[i] = isNew;}
+		newKeys += isNew;
+	}
+	return newKeys;
 }
 
 /**
- *	@brief Inserts a new key-value pair into the table.
+ *	@brief Adds `delta` to the value of `key`, inserting the key with value
+ *		`0` first if it is missing, and returns the value before the addition.
  *
- *	Returns `true` if a unique key is inserted. Also `size` is increased.
+ *	Unlike a `get` followed by an `insert`, the key is probed for only once.
  *
- *	Returns `false` if a duplicate key is attempted to be inserted.
+ *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+ */
+size_t HashTable::fetch_add(std::string_view key, size_t delta) {
+	return this->fetch_add(key, this->hasher(key), delta);
+}
+
+/** Like `fetch_add`, with the hash code of `key` already computed. */
+size_t HashTable::fetch_add(std::string_view key, size_t keyHash, size_t delta) {
+	size_t &value = this->findOrInsert(key, keyHash, 0).first->valueOf();
+	const size_t previous = value;
+	value += delta;
+	return previous;
+}
+
+/**
+ *	Shared probe of `insert`, `upsert`, `fetch_add` and `operator[]`. Returns
+ *	the bucket holding `key`, and `true` if the key was absent and has just
+ *	been inserted with `value`.
  *
- *	The hash code is determined using the key. It is then used modulo capacity
- *	as the bucket number in probe index `0`. If a probed bucket is occupied
+ *	The hash code is determined using the key. The probing strategy maps it
+ *	to the bucket number in probe index `0`. If a probed bucket is occupied
  *	but the keys themselves are not equal, increment the probe sequence index
- *	until an `EAR` or `ESS` bucket is reached.
+ *	until an `ESS` bucket is reached. The first `EAR` bucket on the way is
+ *	remembered, so a new key can reuse it.
  *
- *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+ *	Live entries and tombstones together must stay below the max load factor.
+ *	If the new key would reach it, the table is rebuilt before the key is
+ *	placed, so the returned bucket stays valid.
  */
-bool HashTable::insert(const std::string &key, const size_t &value) {
-	bool uniqueInsert = true;
+std::pair<HashTableBucket *, bool> HashTable::findOrInsert(std::string_view key, size_t keyHash, const size_t &value) {
+	ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
 
-	/**
-	 *	Determine the hash code for the string.
-	 *	The hash itself modulo capacity is then the initial bucket number.
-	 *	It is also the resolved bucket number at the 0th probe.
-	 */
-	const size_t bucketIndex = std::hash<std::string>{}(key) % this->capacity();
-
-	/**
-	 *	If a bucket is occupied, but the keys themselves are not equal, increment the
-	 *	probe sequence index until an `EAR` or `ESS` bucket is reached.
-	 */
-	size_t probeIndex = 0, finalBucketIndex;
+	HashTableBucket *freeBucket = nullptr;
 	while (true) {
-		finalBucketIndex = (bucketIndex + this->offsets[probeIndex]) % this->capacity();
-		HashTableBucket &bucket = this->tableData[finalBucketIndex];
-		if ((bucket.getKey() == key) || bucket.isEmpty()) {
-			uniqueInsert &= (bucket.getKey() != key);
-			if (bucket.isEmpty()) {bucket.load(key, value);}
-			else {bucket.valueOf() = value;}
+		HashTableBucket &bucket = this->tableData[probe.index];
+		if (normalAndEqual(bucket, key, keyHash)) {
+			return {&bucket, false};
+		} else if (bucket.isEmptySinceStart()) {
+			if (freeBucket == nullptr) {freeBucket = &bucket;}
 			break;
 		} else {
-			++probeIndex;
+			if (bucket.isEmptyAfterRemove() && freeBucket == nullptr) {freeBucket = &bucket;}
+			this->probing.advance(probe, this->indexing);
 			continue;
 		}
 	}
 
-	if (uniqueInsert) {++this->length;}
-	if (this->alpha() >= 0.5) {this->resize();}
-	return uniqueInsert;
+	const size_t tombstonesAfter = this->tombstones - (freeBucket->isEmptyAfterRemove() ? 1 : 0);
+	const size_t newCapacity = this->growth.rebuildCapacity(this->size() + 1, tombstonesAfter, this->capacity());
+	if (newCapacity > 0) {
+		this->resize(newCapacity);
+
+		// The rebuilt table has no `EAR` buckets, so the key goes to the first `ESS` bucket.
+		probe = this->probing.begin(keyHash, this->indexing);
+		while (!this->tableData[probe.index].isEmptySinceStart()) {this->probing.advance(probe, this->indexing);}
+		freeBucket = &this->tableData[probe.index];
+	}
+
+	if (freeBucket->isEmptyAfterRemove()) {--this->tombstones;}
+	freeBucket->load(key, value, keyHash, this->keyArena);
+	++this->length;
+	return {freeBucket, true};
 }
 
 /**
@@ -135,18 +466,24 @@ bool HashTable::insert(const std::string &key, const size_t &value) {
  *	bucket's contained key is equivalent to the specified key or an `ESS` bucket
  *	is reached.
  *
+ *	Buckets are compared in place, and the key is taken as a `std::string_view`,
+ *	so a lookup from a `const char *` or a slice of a larger buffer allocates nothing.
+ *
  *	The time complexity is bounded to `O(1) <= T <= O(n)`.
  */
-bool HashTable::contains(const std::string &key) const {
-	const size_t bucketIndex = std::hash<std::string>{}(key) % this->capacity();
+bool HashTable::contains(std::string_view key) const {
+	return this->contains(key, this->hasher(key));
+}
+
+/** Like `contains`, with the hash code of `key` already computed. */
+bool HashTable::contains(std::string_view key, size_t keyHash) const {
+	ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
 
-	size_t probeIndex = 0, finalBucketIndex;
 	while (true) {
-		finalBucketIndex = (bucketIndex + this->offsets[probeIndex]) % this->capacity();
-		HashTableBucket bucket = this->tableData[finalBucketIndex];
-		if (normalAndEqual(bucket, key)) {return true;}
+		const HashTableBucket &bucket = this->tableData[probe.index];
+		if (normalAndEqual(bucket, key, keyHash)) {return true;}
 		else if (bucket.isEmptySinceStart()) {return false;}
-		else {++probeIndex; continue;}
+		else {this->probing.advance(probe, this->indexing); continue;}
 	}
 }
 
@@ -155,30 +492,75 @@ bool HashTable::contains(const std::string &key) const {
  *		in addition, removes that key in the table.
  *
  *	A successful removal of a key sets its corresponding bucket to `EAR` and
- *	decrements `size`.
+ *	decrements `size`. The `EAR` buckets are counted, and `insert` rebuilds the
+ *	table once live entries and `EAR` buckets together reach the max load
+ *	factor, so an `ESS` bucket always ends the probe sequence.
+ *
+ *	The arena bytes of a removed long key are counted too, and the table is
+ *	rebuilt at its capacity once they outweigh the live keys, see `wastesArena`.
  *
  *	The time complexity is bounded to `O(1) <= T <= O(n)`.
  */
-bool HashTable::remove(const std::string &key) {
-	bool keyRemoved = false;
-	const size_t bucketIndex = std::hash<std::string>{}(key) % this->capacity();
+bool HashTable::remove(std::string_view key) {
+	return this->remove(key, this->hasher(key));
+}
+
+/** Like `remove`, with the hash code of `key` already computed. */
+bool HashTable::remove(std::string_view key, size_t keyHash) {
+	ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
 
-	size_t probeIndex = 0, finalBucketIndex;
 	while (true) {
-		finalBucketIndex = (bucketIndex + this->offsets[probeIndex]) % this->capacity();
-		HashTableBucket &bucket = this->tableData[finalBucketIndex];
-		if (normalAndEqual(bucket, key) || bucket.isEmptySinceStart()) {
-			keyRemoved |= (bucket.getKey() == key);
-			if (keyRemoved) {bucket.makeEAR();}
-			break;
-		} else {
-			++probeIndex;
-			continue;
-		}
+		const HashTableBucket &bucket = this->tableData[probe.index];
+		if (normalAndEqual(bucket, key, keyHash)) {break;}
+		else if (bucket.isEmptySinceStart()) {return false;}
+		else {this->probing.advance(probe, this->indexing); continue;}
+	}
+
+	if (this->tableData[probe.index].keyInArena()) {this->removedKeyBytes += key.size();}
+	if constexpr (usesBackwardShift<Probing>) {
+		this->shiftBack(probe.index);
+	} else {
+		this->tableData[probe.index].makeEAR();
+		++this->tombstones;
 	}
 
-	if (keyRemoved) {--this->length;}
-	return keyRemoved;
+	--this->length;
+	if (this->wastesArena()) {this->resize(this->capacity());}
+	return true;
+}
+
+/**
+ *	Returns `true` once the arena bytes of removed keys exceed those of the
+ *	live keys, the bucket array and one arena chunk. A rebuild then copies
+ *	at most as many key bytes as were removed since the last one, and scans
+ *	at most as many bucket bytes, so it costs `O(1)` per removed byte.
+ */
+bool HashTable::wastesArena() const {
+	const size_t liveKeyBytes = this->keyArena.bytesUsed() - this->removedKeyBytes;
+	return this->removedKeyBytes > std::max({liveKeyBytes, this->capacity() * sizeof(HashTableBucket), StringArena::CHUNK_SIZE});
+}
+
+/**
+ *	Backward-shift deletion for `LinearShiftProbing`. Starting from the removed
+ *	bucket, every later entry of the cluster whose home bucket does not lie
+ *	between the gap and itself moves back into the gap. The last gap becomes
+ *	`ESS`, so no `EAR` bucket is ever left behind.
+ */
+void HashTable::shiftBack(size_t hole) {
+	size_t bucketIndex = hole;
+	while (true) {
+		bucketIndex = this->indexing.wrap(bucketIndex + 1);
+		HashTableBucket &bucket = this->tableData[bucketIndex];
+		if (bucket.isEmptySinceStart()) {break;}
+
+		const size_t home = this->indexing.home(bucket.getHash());
+		if (cyclicallyBetween(hole, home, bucketIndex)) {continue;}
+
+		this->tableData[hole] = std::move(bucket);
+		hole = bucketIndex;
+	}
+
+	this->tableData[hole].makeESS();
 }
 
 /**
@@ -188,39 +570,103 @@ bool HashTable::remove(const std::string &key) {
  *
  *	The time complexity is bounded to `O(1) <= T <= O(n)`.
  */
-std::optional<size_t> HashTable::get(const std::string &key) const {
-	const size_t bucketIndex = std::hash<std::string>{}(key) % this->capacity();
+std::optional<size_t> HashTable::get(std::string_view key) const {
+	return this->get(key, this->hasher(key));
+}
+
+/** Like `get`, with the hash code of `key` already computed. */
+std::optional<size_t> HashTable::get(std::string_view key, size_t keyHash) const {
+	ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
 
-	size_t probeIndex = 0, finalBucketIndex;
 	while (true) {
-		finalBucketIndex = (bucketIndex + this->offsets[probeIndex]) % this->capacity();
-		HashTableBucket bucket = this->tableData[finalBucketIndex];
-		if (normalAndEqual(bucket, key)) {return std::optional<size_t>(bucket.valueOf());}
+		const HashTableBucket &bucket = this->tableData[probe.index];
+		if (normalAndEqual(bucket, key, keyHash)) {return std::optional<size_t>(bucket.valueOf());}
 		else if (bucket.isEmptySinceStart()) {return std::nullopt;}
-		else {++probeIndex; continue;}
+		else {this->probing.advance(probe, this->indexing); continue;}
 	}
 }
 
 /**
- *	Returns a reference to the value associated with the specified key.
- *	If a key is not found in the table, this method is ill-formed, causing
- *	undesirable behavior.
+ *	Looks up every key of `keys` and stores its value, or `nullopt`, at the
+ *	same index of `results`, which must hold at least `keys.size()` entries.
  *
- *	This is different than inserting a new key with its value if the key
- *	is not in the table.
+ *	Keys are resolved in batches of `PREFETCH_BATCH`. All keys of a batch are
+ *	hashed and their home buckets prefetched before the first one is probed,
+ *	so the cache misses of a batch overlap instead of stalling one by one.
+ *
+ *	The time complexity is bounded to `O(k) <= T <= O(k * n)` for `k` keys.
+ */
+void HashTable::get_many(std::span<const std::string_view> keys, std::span<std::optional<size_t>> results) const {
+	if (results.size() < keys.size()) {throw std::invalid_argument("get_many needs one result per key");}
+
+	ProbeCursor probes[PREFETCH_BATCH];
+	size_t hashes[PREFETCH_BATCH];
+	for (size_t first = 0; first < keys.size(); first += PREFETCH_BATCH) {
+		const std::span<const std::string_view> batch = keys.subspan(first, std::min(PREFETCH_BATCH, keys.size() - first));
+		this->prefetchBatch(batch, probes, hashes);
+		for (size_t i = 0; i < batch.size(); ++i) {
+			const HashTableBucket *bucket = this->find(batch[i], hashes[i], probes[i]);
+			results[first + i] = (bucket != nullptr) ? std::optional<size_t>(bucket->valueOf()) : std::nullopt;
+		}
+	}
+}
+
+/** Like `get_many`, but stores whether each key exists in the table. */
+void HashTable::contains_many(std::span<const std::string_view> keys, std::span<bool> results) const {
+	if (results.size() < keys.size()) {throw std::invalid_argument("contains_many needs one result per key");}
+
+	ProbeCursor probes[PREFETCH_BATCH];
+	size_t hashes[PREFETCH_BATCH];
+	for (size_t first = 0; first < keys.size(); first += PREFETCH_BATCH) {
+		const std::span<const std::string_view> batch = keys.subspan(first, std::min(PREFETCH_BATCH, keys.size() - first));
+		this->prefetchBatch(batch, probes, hashes);
+		for (size_t i = 0; i < batch.size(); ++i) {results[first + i] = (this->find(batch[i], hashes[i], probes[i]) != nullptr);}
+	}
+}
+
+/** Hashes every key of `batch`, stores its hash code and starting probe cursor and prefetches its home bucket. */
+void HashTable::prefetchBatch(std::span<const std::string_view> batch, ProbeCursor *probes, size_t *hashes) const {
+	for (size_t i = 0; i < batch.size(); ++i) {
+		hashes[i] = this->hasher(batch[i]);
+		probes[i] = this->probing.begin(hashes[i], this->indexing);
+		prefetch(&this->tableData[probes[i].index]);
+	}
+}
+
+/** Probes for `key`, whose hash code is `keyHash`, from `probe` on, and returns its bucket or `nullptr`. */
+const HashTableBucket * HashTable::find(std::string_view key, size_t keyHash, ProbeCursor probe) const {
+	while (true) {
+		const HashTableBucket &bucket = this->tableData[probe.index];
+		if (normalAndEqual(bucket, key, keyHash)) {return &bucket;}
+		else if (bucket.isEmptySinceStart()) {return nullptr;}
+		else {this->probing.advance(probe, this->indexing); continue;}
+	}
+}
+
+/**
+ *	Returns a reference to the value associated with the specified key.
+ *	If a key is not found in the table, it is inserted with value `0`
+ *	first, like `std::unordered_map::operator[]`, so the reference always
+ *	belongs to a normal bucket.
  *
  *	The time complexity is bounded to `O(1) <= T <= O(n)`.
  */
-size_t & HashTable::operator[](const std::string &key) {
-	const size_t bucketIndex = std::hash<std::string>{}(key) % this->capacity();
+size_t & HashTable::operator[](std::string_view key) {
+	return this->findOrInsert(key, this->hasher(key), 0).first->valueOf();
+}
+
+/**
+ *	Returns the number of buckets a lookup of `key` inspects, including the
+ *	bucket holding the key or the `ESS` bucket that ends the probe sequence.
+ */
+size_t HashTable::probeLength(std::string_view key) const {
+	const size_t keyHash = this->hasher(key);
+	ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
 
-	size_t probeIndex = 0, finalBucketIndex;
 	while (true) {
-		finalBucketIndex = (bucketIndex + this->offsets[probeIndex]) % this->capacity();
-		HashTableBucket &bucket = this->tableData[finalBucketIndex];
-		if (normalAndEqual(bucket, key) || bucket.isEmptySinceStart()) {
-			return bucket.valueOf();
-		} else {++probeIndex; continue;}
+		const HashTableBucket &bucket = this->tableData[probe.index];
+		if (normalAndEqual(bucket, key, keyHash) || bucket.isEmptySinceStart()) {return probe.probe + 1;}
+		else {this->probing.advance(probe, this->indexing); continue;}
 	}
 }
 
@@ -232,9 +678,9 @@ size_t & HashTable::operator[](const std::string &key) {
 std::vector<std::string> HashTable::keys() const {
 	std::vector<std::string> keyList;
 
-	for (HashTableBucket bucket : this->tableData) {
+	for (const HashTableBucket &bucket : this->tableData) {
 		if (!bucket.isEmpty()) {
-			keyList.push_back(bucket.getKey());
+			keyList.emplace_back(bucket.getKey());
 		}
 	}
 
@@ -243,39 +689,134 @@ std::vector<std::string> HashTable::keys() const {
 }
 
 /**
- *	Resizing the hash table changes the effective capacity, usually by doubling
- *	the current capacity. 
+ *	Resizing the hash table changes the effective capacity to at least
+ *	`newCapacity`, rounded up by the indexing strategy. On growth this is the
+ *	current capacity times the growth factor, doubling by default.
  *
  *	Because the capacity is changed, all internal vectors need to be sized
  *	correctly and to have every normal bucket in the previous vector containing
  *	table data be transferred to new bucket indices in the new table.
+ *
+ *	Keys living in the arena are copied into a fresh arena as their buckets
+ *	move, so the bytes of removed keys are freed with the old arena.
  */
-void HashTable::resize() {
-	const size_t newSize = this->capacity() * 2;
-	this->generate_permutation(newSize);
-	std::vector<HashTableBucket> newTableData(newSize);
+void HashTable::resize(size_t newCapacity) {
+#ifdef HASHTABLE_STATS
+	const auto start = std::chrono::steady_clock::now();
+#endif
+
+	const size_t newSize = Indexing::roundCapacity(newCapacity);
+	std::pmr::vector<HashTableBucket> oldTableData(newSize, this->tableData.get_allocator());
+	oldTableData.swap(this->tableData);
+	StringArena oldKeyArena(std::move(this->keyArena));
+	this->indexing.reset(newSize);
+	this->probing.reset(newSize);
 
-	for (HashTableBucket &bucket : this->tableData) {
+	/**
+	 *	Every key is unique, so each normal bucket moves into the first `ESS`
+	 *	bucket along its probe sequence without comparing keys. The stored hash
+	 *	codes spare hashing every key again, and moving the buckets spares
+	 *	copying the keys stored inline; only arena keys are copied.
+	 */
+	for (HashTableBucket &bucket : oldTableData) {
 		if (!bucket.isEmpty()) {
-			std::string bucketKey = bucket.getKey();
-			const size_t bucketIndex = std::hash<std::string>{}(bucketKey) % newSize;
-
-			size_t probeIndex = 0, finalBucketIndex;
-			while (true) {
-				finalBucketIndex = (bucketIndex + this->offsets[probeIndex]) % newSize;
-				HashTableBucket &bucket2 = newTableData[finalBucketIndex];
-				if ((bucket2.getKey() == bucketKey) || bucket2.isEmpty()) {
-					bucket2 = bucket;
-					break;
-				} else {
-					++probeIndex;
-					continue;
-				}
+			ProbeCursor probe = this->probing.begin(bucket.getHash(), this->indexing);
+			while (!this->tableData[probe.index].isEmptySinceStart()) {
+				this->probing.advance(probe, this->indexing);
 			}
+			HashTableBucket &newBucket = this->tableData[probe.index];
+			newBucket = std::move(bucket);
+			if (newBucket.keyInArena()) {newBucket.load(newBucket.getKey(), newBucket.valueOf(), newBucket.getHash(), this->keyArena);}
 		}
 	}
 
-	this->tableData = newTableData;
+	this->tombstones = 0;
+	this->removedKeyBytes = 0;
+
+#ifdef HASHTABLE_STATS
+	++this->resizeCount;
+	this->resizeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#endif
+}
+
+/**
+ *	Writes the table to `path` as an image that `open_mapped` can serve
+ *	lookups from without rebuilding it; see `HashTableMapped.h` for the
+ *	format. The image is written next to `path` and renamed over it once
+ *	complete, so a reader never maps a half-written image. Throws
+ *	`std::runtime_error` if the file cannot be written.
+ */
+void HashTable::save(const std::string &path) const {
+	using namespace HashTableImage;
+
+	const std::string partialPath = path + ".partial";
+	std::ofstream out(partialPath, std::ios::binary | std::ios::trunc);
+	if (!out) {throw std::runtime_error("cannot write " + partialPath);}
+
+	Header header{};
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	// Bucket records go out in blocks, and each normal bucket points at the next free key offset.
+	uint64_t payloadChecksum = CHECKSUM_SEED;
+	uint64_t keyOffset = 0;
+	std::vector<Bucket> block;
+	block.reserve(4096);
+	for (size_t bucketIndex = 0; bucketIndex < this->capacity(); ++bucketIndex) {
+		const HashTableBucket &bucket = this->tableData[bucketIndex];
+		Bucket record{};
+		if (bucket.isEmptySinceStart()) {record.state = ESS;}
+		else if (bucket.isEmptyAfterRemove()) {record.state = EAR;}
+		else {
+			record.state = NORMAL;
+			record.hash = bucket.getHash();
+			record.value = bucket.valueOf();
+			record.keyOffset = keyOffset;
+			record.keyLength = static_cast<uint32_t>(bucket.getKey().size());
+			keyOffset += record.keyLength;
+		}
+		block.push_back(record);
+
+		if (block.size() == block.capacity() || bucketIndex + 1 == this->capacity()) {
+			const size_t bytes = block.size() * sizeof(Bucket);
+			payloadChecksum = checksum(block.data(), bytes, payloadChecksum);
+			out.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(bytes));
+			block.clear();
+		}
+	}
+
+	for (const HashTableBucket &bucket : this->tableData) {
+		if (bucket.isEmpty()) {continue;}
+		const std::string_view key = bucket.getKey();
+		payloadChecksum = checksum(key.data(), key.size(), payloadChecksum);
+		out.write(key.data(), static_cast<std::streamsize>(key.size()));
+	}
+
+	std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.byteOrder = ENDIAN_MARK;
+	header.capacity = this->capacity();
+	header.size = this->size();
+	header.keyBytes = keyOffset;
+	header.hashSeed = this->hasher.seed();
+	header.hashCheck = this->hasher(HASH_CHECK_KEY);
+	std::strncpy(header.probing, PROBING_NAME, NAME_SIZE - 1);
+	std::strncpy(header.indexing, INDEXING_NAME, NAME_SIZE - 1);
+	header.payloadChecksum = payloadChecksum;
+	header.headerChecksum = headerChecksum(header);
+	out.seekp(0);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	out.close();
+	if (!out) {throw std::runtime_error("cannot write " + partialPath);}
+	std::filesystem::rename(partialPath, path);
+}
+
+/**
+ *	Maps an image written by `save` for read-only lookups, in time that does
+ *	not depend on the number of keys. See `MappedHashTable`.
+ */
+MappedHashTable HashTable::open_mapped(const std::string &path) {
+	return MappedHashTable(path);
 }
 
 /**
@@ -288,15 +829,15 @@ void HashTable::resize() {
  */
 std::ostream & operator<<(std::ostream &os, const HashTable &hashTable) {
 	size_t printedBuckets = 0;
-	os << std::string{"["};
+	os << "[";
 	for (size_t bucketIndex = 0; bucketIndex < hashTable.capacity(); ++bucketIndex) {
-		HashTableBucket bucket = hashTable.tableData[bucketIndex];
+		const HashTableBucket &bucket = hashTable.tableData[bucketIndex];
 		if (!bucket.isEmpty()) {
-			if (printedBuckets > 0) {os << std::string{", "};}
-			os << bucketIndex << std::string{": "} << bucket;
+			if (printedBuckets > 0) {os << ", ";}
+			os << bucketIndex << ": " << bucket;
 			++printedBuckets;
 		}
 	}
-	os << std::string{"]"};
+	os << "]";
 	return os;
 }
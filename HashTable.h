@@ -6,11 +6,54 @@
 #define HASHTABLE_H
 
 #include <vector>
+#include <memory_resource>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
 #include "HashTableBucket.h"
+#include "HashTableHash.h"
+#include "HashTableProbing.h"
+#include "HashTableGrowth.h"
+#include "HashTableStats.h"
+
+/**
+ *	Probing and indexing strategies used by `HashTable`, chosen at compile
+ *	time from `HashTableProbing.h`, e.g. `-DHASHTABLE_PROBING=TriangularProbing`.
+ *	`PermutationProbing` is the original pseudo-random permutation, and
+ *	`PrimeIndexing` keeps non-power-of-two capacities.
+ */
+#ifndef HASHTABLE_PROBING
+#define HASHTABLE_PROBING LinearProbing
+#endif
+
+#ifndef HASHTABLE_INDEXING
+#define HASHTABLE_INDEXING PowerOfTwoIndexing
+#endif
+
+/**
+ *	Key hash used by `HashTable`, chosen at compile time from
+ *	`HashTableHash.h`. `StringHash` is the unseeded `std::hash`;
+ *	`-DHASHTABLE_HASH=SipHash` gives every table its own random seed, for
+ *	tables keyed by untrusted strings. `WyHash`, `AesHash` and `Crc32cHash`
+ *	are faster hashes for trusted keys.
+ */
+#ifndef HASHTABLE_HASH
+#define HASHTABLE_HASH StringHash
+#endif
+
+class MappedHashTable;
 
 class HashTable {
 	public:
+		using Probing = HASHTABLE_PROBING;
+		using Indexing = HASHTABLE_INDEXING;
+		using Hash = HASHTABLE_HASH;
+
+		static_assert(!Probing::requiresPowerOfTwo || Indexing::powerOfTwo, "probing strategy needs a power-of-two capacity");
+
+		/** Fewest pairs for which `insert_range` uses more than the calling thread. */
+		static constexpr size_t PARALLEL_INSERT_THRESHOLD = 1 << 16;
 
 		/**
 		 *	Placeholder value to store the default capacity for the hash table.
@@ -19,33 +62,110 @@ class HashTable {
 		 */
 		static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
 
-		HashTable(size_t initCapacity = DEFAULT_INITIAL_CAPACITY);
+		HashTable(size_t initCapacity = DEFAULT_INITIAL_CAPACITY, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+		HashTable(const HashTable &other, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+		HashTable(HashTable &&other) = default;
+
+		HashTable & operator=(const HashTable &other);
+		HashTable & operator=(HashTable &&other) = default;
+
+		bool insert(std::string_view key, const size_t &value);
+		size_t insert_range(std::span<const std::pair<std::string_view, size_t>> entries, std::span<bool> inserted = {}, size_t threads = 0);
+		bool remove(std::string_view key);
+		bool contains(std::string_view key) const;
+
+		std::optional<size_t> get(std::string_view key) const;
 
-		bool insert(const std::string &key, const size_t &value);
-		bool remove(const std::string &key);
-		bool contains(const std::string &key) const;
+		void get_many(std::span<const std::string_view> keys, std::span<std::optional<size_t>> results) const;
+		void contains_many(std::span<const std::string_view> keys, std::span<bool> results) const;
 
-		std::optional<size_t> get(const std::string &key) const;
+		size_t & operator[](std::string_view key);
 
-		size_t & operator[](const std::string &key);
+		/**
+		 *	@brief Calls `update(value)` on the value of `key`, inserting the key
+		 *		with value `0` first if it is missing, with a single probe sequence.
+		 *
+		 *	Returns `true` if the key was inserted.
+		 */
+		template<typename Fn>
+		bool upsert(std::string_view key, Fn &&update) {return this->upsert(key, this->hasher(key), std::forward<Fn>(update));}
+
+		size_t fetch_add(std::string_view key, size_t delta);
+
+		size_t probeLength(std::string_view key) const;
 
 		std::vector<std::string> keys() const;
 
 		double alpha() const;
 
+		double max_load_factor() const;
+		void max_load_factor(double maxLoadFactor);
+		double growth_factor() const;
+		void growth_factor(double growthFactor);
+
+		void reserve(size_t count);
+		void rehash(size_t count);
+
 		size_t capacity() const;
 		size_t size() const;
+		size_t tombstoneCount() const;
+
+		void clear();
+		size_t arenaBytes() const;
+
+		HashTableStats stats() const;
+
+		void save(const std::string &path) const;
+		static MappedHashTable open_mapped(const std::string &path);
 
 		friend std::ostream & operator<<(std::ostream &os, const HashTable &hashTable);
 
 	private:
-		std::vector<size_t> offsets;
-		std::vector<HashTableBucket> tableData;
+		friend class ShardedHashTable;
+
+		Indexing indexing;
+		Probing probing;
+		GrowthPolicy growth;
+		Hash hasher;
+		std::pmr::vector<HashTableBucket> tableData;
+		StringArena keyArena;
 
 		size_t length;
+		size_t tombstones;
+
+		/** Arena bytes of removed keys, which stay in the arena until the next `resize`. */
+		size_t removedKeyBytes;
 
-		void generate_permutation(const size_t length);
-		void resize();
+#ifdef HASHTABLE_STATS
+		size_t resizeCount = 0;
+		double resizeSeconds = 0.0;
+#endif
+
+		/**
+		 *	Overloads for a key whose hash code `keyHash` the caller already
+		 *	computed with this table's key hash, as `ShardedHashTable` does to
+		 *	route the key to a shard.
+		 */
+		HashTable(size_t initCapacity, const Hash &hasher, std::pmr::memory_resource *resource);
+		bool insert(std::string_view key, size_t keyHash, const size_t &value);
+		bool remove(std::string_view key, size_t keyHash);
+		bool contains(std::string_view key, size_t keyHash) const;
+		std::optional<size_t> get(std::string_view key, size_t keyHash) const;
+		size_t fetch_add(std::string_view key, size_t keyHash, size_t delta);
+
+		template<typename Fn>
+		bool upsert(std::string_view key, size_t keyHash, Fn &&update) {
+			const auto [bucket, inserted] = this->findOrInsert(key, keyHash, 0);
+			update(bucket->valueOf());
+			return inserted;
+		}
+
+		std::pair<HashTableBucket *, bool> findOrInsert(std::string_view key, size_t keyHash, const size_t &value);
+		const HashTableBucket * find(std::string_view key, size_t keyHash, ProbeCursor probe) const;
+		void prefetchBatch(std::span<const std::string_view> keys, ProbeCursor *probes, size_t *hashes) const;
+		void resize(size_t newCapacity);
+		void shiftBack(size_t hole);
+		bool wastesArena() const;
 };
 
 #endif
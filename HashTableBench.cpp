@@ -0,0 +1,251 @@
+/**
+ *	HashTableBench.cpp
+ *
+ *	Microbenchmark suite of `HashTable` against `FlatHashtable_t` and
+ *	`std::unordered_map`. Every operation is timed for every key
+ *	distribution at table sizes from `2^10` keys, which fit in L1, up to
+ *	`2^maxLog2` keys, far beyond the last-level cache at the default:
+ *
+ *		insert    inserting every key into an empty table
+ *		hit       looking up keys in the table
+ *		miss      looking up keys not in the table
+ *		remove    removing every key from a full table
+ *		churn     removing a key and inserting a new one, at a steady size
+ *		update    incrementing values through `operator[]`
+ *		iterate   collecting every key, like `HashTable::keys()`
+ *		resize    rehashing a full table to twice its capacity
+ *
+ *	Keys are `uniform` random numbers, `sequential` numbers, `short` random
+ *	strings that fit in a key inline, or `long` random strings of 64 bytes.
+ *	`zipfian` uses the uniform keys, but its hits and updates pick keys with
+ *	a Zipf distribution, so a few hot keys take most of them.
+ *
+ *	Each case is repeated until it has run for at least `min seconds`. The
+ *	results are printed to standard output as JSON, in the layout of Google
+ *	Benchmark, so runs can be saved and compared to catch regressions;
+ *	progress goes to standard error.
+ *
+ *	Usage: `HashTableBench [max log2 size] [min seconds]`, defaults are `22`
+ *	and `0.1`.
+ */
+
+#include "HashTable.h"
+#include "HashTableBenchUtil.h"
+#include "HashTableFlat.h"
+#include "HashTableMapped.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using FlatTable = FlatHashtable_t<std::string, size_t, StringHash, std::equal_to<>, GroupProbing>;
+using StdTable = std::unordered_map<std::string, size_t, StringHash, std::equal_to<>>;
+
+/**
+ *	The operations the suite times, for each table type. `HashTable` and
+ *	`FlatHashtable_t` share an interface; `std::unordered_map` is adapted.
+ */
+template<typename Table>
+struct BenchTable {
+	static void insert(Table &table, const std::string &key, size_t value) {table.insert(key, value);}
+	static bool remove(Table &table, const std::string &key) {return table.remove(key);}
+	static std::vector<std::string> keys(const Table &table) {return table.keys();}
+	static void grow(Table &table) {table.rehash(2 * table.capacity());}
+};
+
+template<>
+struct BenchTable<StdTable> {
+	static void insert(StdTable &table, const std::string &key, size_t value) {table.insert_or_assign(key, value);}
+	static bool remove(StdTable &table, const std::string &key) {return table.erase(key) > 0;}
+
+	static std::vector<std::string> keys(const StdTable &table) {
+		std::vector<std::string> keyList;
+		keyList.reserve(table.size());
+		for (const auto &entry : table) {keyList.push_back(entry.first);}
+		return keyList;
+	}
+
+	static void grow(StdTable &table) {table.rehash(2 * table.bucket_count());}
+};
+
+/** Keys of one distribution and size, and the orders they are used in. */
+struct KeySet {
+	std::vector<std::string> keys;
+
+	/** Keys never inserted, for misses and as the new keys of churn. */
+	std::vector<std::string> missing;
+
+	/** Indices into `keys` for hits and updates. */
+	std::vector<size_t> accesses;
+
+	/** Indices into `keys` for removals, every key once. */
+	std::vector<size_t> removals;
+};
+
+KeySet makeKeySet(const std::string &distribution, size_t n) {
+	std::mt19937_64 random(n);
+	auto makeKey = [&](size_t i) -> std::string {
+		if (distribution == "sequential") {return "key:" + std::to_string(i);}
+		if (distribution == "short") {return randomString(random, 7);}
+		if (distribution == "long") {return randomString(random, 64);}
+		return "key:" + std::to_string(random());
+	};
+
+	KeySet set;
+	set.keys.resize(n);
+	set.missing.resize(n);
+	for (size_t i = 0; i < n; ++i) {set.keys[i] = makeKey(i);}
+	for (size_t i = 0; i < n; ++i) {set.missing[i] = makeKey(n + i);}
+
+	set.removals.resize(n);
+	for (size_t i = 0; i < n; ++i) {set.removals[i] = i;}
+	std::shuffle(set.removals.begin(), set.removals.end(), random);
+
+	// Ranks go through the shuffled order, so the hot keys are spread over the table.
+	if (distribution == "zipfian") {
+		set.accesses = zipfRanks(random, n, n);
+		for (size_t &access : set.accesses) {access = set.removals[access];}
+	} else {
+		set.accesses = set.removals;
+		std::shuffle(set.accesses.begin(), set.accesses.end(), random);
+	}
+	return set;
+}
+
+/** Written by every timed loop, so none of them can be optimized away. */
+volatile size_t sink = 0;
+
+/** Mean nanoseconds per operation, and how many times the case was run. */
+struct Timing {
+	double nanosPerOperation;
+	size_t iterations;
+};
+
+/**
+ *	Runs `setup` and then times `run`, which does `operations` operations,
+ *	until `run` has taken at least `minSeconds` in total.
+ */
+template<typename Setup, typename Run>
+Timing measure(double minSeconds, size_t operations, Setup &&setup, Run &&run) {
+	double seconds = 0.0;
+	size_t iterations = 0;
+	do {
+		setup();
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		++iterations;
+	} while (seconds < minSeconds);
+
+	return Timing{seconds * 1e9 / static_cast<double>(iterations * operations), iterations};
+}
+
+/** Prints one result as a Google Benchmark entry, with the case as extra fields. */
+void report(const char *table, const char *operation, const std::string &distribution, size_t size, Timing timing) {
+	static bool first = true;
+	std::printf("%s\n    {\n", first ? "" : ",");
+	first = false;
+
+	std::printf("      \"name\": \"%s/%s/%s/%zu\",\n", operation, table, distribution.c_str(), size);
+	std::printf("      \"run_type\": \"iteration\",\n");
+	std::printf("      \"iterations\": %zu,\n", timing.iterations);
+	std::printf("      \"real_time\": %.3f,\n", timing.nanosPerOperation);
+	std::printf("      \"cpu_time\": %.3f,\n", timing.nanosPerOperation);
+	std::printf("      \"time_unit\": \"ns\",\n");
+	std::printf("      \"items_per_second\": %.1f,\n", 1e9 / timing.nanosPerOperation);
+	std::printf("      \"table\": \"%s\",\n", table);
+	std::printf("      \"operation\": \"%s\",\n", operation);
+	std::printf("      \"distribution\": \"%s\",\n", distribution.c_str());
+	std::printf("      \"size\": %zu\n", size);
+	std::printf("    }");
+	std::fflush(stdout);
+
+	std::fprintf(stderr, "%-8s %-20s %-11s %9zu %10.1f ns\n", operation, table, distribution.c_str(), size, timing.nanosPerOperation);
+}
+
+/** Times every operation on `Table` for one key set. */
+template<typename Table>
+void runCases(const char *name, const std::string &distribution, const KeySet &set, double minSeconds) {
+	using Ops = BenchTable<Table>;
+	const size_t n = set.keys.size();
+	std::unique_ptr<Table> table;
+
+	auto empty = [&]() {table = std::make_unique<Table>();};
+	auto full = [&]() {
+		empty();
+		for (size_t i = 0; i < n; ++i) {Ops::insert(*table, set.keys[i], i);}
+	};
+	auto none = []() {};
+
+	report(name, "insert", distribution, n, measure(minSeconds, n, empty, [&]() {
+		for (size_t i = 0; i < n; ++i) {Ops::insert(*table, set.keys[i], i);}
+	}));
+
+	full();
+	report(name, "hit", distribution, n, measure(minSeconds, n, none, [&]() {
+		size_t found = 0;
+		for (const size_t access : set.accesses) {found += table->contains(set.keys[access]);}
+		sink = found;
+	}));
+	report(name, "miss", distribution, n, measure(minSeconds, n, none, [&]() {
+		size_t found = 0;
+		for (const std::string &key : set.missing) {found += table->contains(key);}
+		sink = found;
+	}));
+	report(name, "update", distribution, n, measure(minSeconds, n, none, [&]() {
+		for (const size_t access : set.accesses) {++(*table)[set.keys[access]];}
+	}));
+	report(name, "iterate", distribution, n, measure(minSeconds, n, none, [&]() {
+		sink = Ops::keys(*table).size();
+	}));
+
+	report(name, "remove", distribution, n, measure(minSeconds, n, full, [&]() {
+		size_t removed = 0;
+		for (const size_t removal : set.removals) {removed += Ops::remove(*table, set.keys[removal]);}
+		sink = removed;
+	}));
+
+	// Each key is replaced by a missing one, oldest first, so the size stays at `n`.
+	report(name, "churn", distribution, n, measure(minSeconds, n, full, [&]() {
+		for (size_t i = 0; i < n; ++i) {
+			Ops::remove(*table, set.keys[i]);
+			Ops::insert(*table, set.missing[i], i);
+		}
+	}));
+
+	report(name, "resize", distribution, n, measure(minSeconds, n, full, [&]() {
+		Ops::grow(*table);
+	}));
+}
+
+int main(int argc, char **argv) {
+	const unsigned maxLog2 = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : 22;
+	const double minSeconds = (argc > 2) ? std::atof(argv[2]) : 0.1;
+	const std::string distributions[] = {"uniform", "zipfian", "sequential", "short", "long"};
+
+	std::printf("{\n  \"context\": {\n");
+	std::printf("    \"executable\": \"%s\",\n", argv[0]);
+	std::printf("    \"probing\": \"%s\",\n", HashTableImage::PROBING_NAME);
+	std::printf("    \"indexing\": \"%s\",\n", HashTableImage::INDEXING_NAME);
+	std::printf("    \"min_seconds\": %.3f\n", minSeconds);
+	std::printf("  },\n  \"benchmarks\": [");
+
+	for (unsigned log2Size = 10; log2Size <= maxLog2; log2Size += 3) {
+		for (const std::string &distribution : distributions) {
+			const KeySet set = makeKeySet(distribution, size_t{1} << log2Size);
+			runCases<HashTable>("HashTable", distribution, set, minSeconds);
+			runCases<FlatTable>("FlatHashtable_t", distribution, set, minSeconds);
+			runCases<StdTable>("std::unordered_map", distribution, set, minSeconds);
+		}
+	}
+
+	std::printf("\n  ]\n}\n");
+	return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ *	HashTableBenchUtil.h
+ *
+ *	Helpers shared by the benchmark and load tools: random keys and skewed
+ *	key ranks for generated workloads, timing per key, and the peak resident
+ *	memory of the process.
+ */
+
+#ifndef HASHTABLEBENCHUTIL_H
+#define HASHTABLEBENCHUTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/** Returns a random string of `length` letters and digits. */
+inline std::string randomString(std::mt19937_64 &random, size_t length) {
+	static constexpr char ALPHABET[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+	std::string key(length, ' ');
+	for (char &c : key) {c = ALPHABET[random() % (sizeof(ALPHABET) - 1)];}
+	return key;
+}
+
+/**
+ *	Returns `count` ranks out of `0, ..., n - 1` with a Zipf distribution of
+ *	exponent `0.99`, so rank `0` is the most frequent.
+ */
+inline std::vector<size_t> zipfRanks(std::mt19937_64 &random, size_t n, size_t count) {
+	std::vector<double> cumulative(n);
+	double total = 0.0;
+	for (size_t rank = 0; rank < n; ++rank) {
+		total += 1.0 / std::pow(static_cast<double>(rank + 1), 0.99);
+		cumulative[rank] = total;
+	}
+
+	std::uniform_real_distribution<double> uniform(0.0, total);
+	std::vector<size_t> ranks(count);
+	for (size_t &rank : ranks) {
+		const auto found = std::lower_bound(cumulative.begin(), cumulative.end(), uniform(random));
+		rank = std::min(static_cast<size_t>(found - cumulative.begin()), n - 1);
+	}
+	return ranks;
+}
+
+/** Returns nanoseconds per key for the time since `start`. */
+inline double nanosPerKey(std::chrono::steady_clock::time_point start, size_t keyCount) {
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(keyCount);
+}
+
+/** Returns the peak resident set size of the process in bytes, or `0` if unknown. */
+inline size_t peakResidentBytes() {
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+		return static_cast<size_t>(usage.ru_maxrss);
+#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+	}
+#endif
+	return 0;
+}
+
+#endif
@@ -11,26 +11,40 @@
  *	The default constructor sets the bucket type to `ESS`
  *	(empty since start).
  */
-HashTableBucket::HashTableBucket() : bucketType(ESS) {}
+HashTableBucket::HashTableBucket() : value(0), hashCode(0) {this->makeESS();}
 
 /**
  *	Sets the bucket type to `NORMAL`, as well as initializing
  *	the key and value for this bucket.
  */
-HashTableBucket::HashTableBucket(const std::string &key, const size_t &value) {this->load(key, value);}
+HashTableBucket::HashTableBucket(std::string_view key, const size_t &value, size_t hashCode, StringArena &arena) {
+	this->load(key, value, hashCode, arena);
+}
 
 /**
  * 	A key-value pair is assigned to this bucket, which also sets the
- * 	bucket type to `NORMAL`.
+ * 	bucket type to `NORMAL`. The full hash code of the key is kept, so
+ * 	the table never hashes the key again when it grows. Keys too long for
+ * 	the key storage are copied into `arena`.
  */
-void HashTableBucket::load(const std::string &key, const size_t &value) {
+void HashTableBucket::load(std::string_view key, const size_t &value, size_t hashCode, StringArena &arena) {
 	this->makeNormal();
-	this->key = key;
+	this->key.assign(key, arena);
 	this->valueOf() = value;
+	this->hashCode = hashCode;
 }
 
-/** Returns the key contained in this bucket. */
-std::string HashTableBucket::getKey() const {return this->key;}
+/**
+ *	Returns a view of the key contained in this bucket, so probes
+ *	can compare keys in place without copying the string.
+ */
+std::string_view HashTableBucket::getKey() const {return this->key.view();}
+
+/** Returns `true` if the key was too long for the key storage and lives in the arena. */
+bool HashTableBucket::keyInArena() const {return this->key.external();}
+
+/** Returns the hash code of the key contained in this bucket. */
+size_t HashTableBucket::getHash() const {return this->hashCode;}
 
 /**
  *	Returns a reference to a value in this bucket.
@@ -38,14 +52,22 @@ std::string HashTableBucket::getKey() const {return this->key;}
  */
 size_t & HashTableBucket::valueOf() {return this->value;}
 
+/** Read-only access to the value in this bucket. */
+const size_t & HashTableBucket::valueOf() const {return this->value;}
+
+/** The bucket type is kept in two spare bits of the key storage. */
+HashTableBucket::BucketType HashTableBucket::bucketType() const {
+	return static_cast<BucketType>(this->key.state());
+}
+
 /** Sets the bucket type to `NORMAL`. */
-void HashTableBucket::makeNormal() {this->bucketType = NORMAL;}
+void HashTableBucket::makeNormal() {this->key.setState(static_cast<unsigned char>(NORMAL));}
 
 /** Sets the bucket type to `ESS`. */
-void HashTableBucket::makeESS() {this->bucketType = ESS;}
+void HashTableBucket::makeESS() {this->key.setState(static_cast<unsigned char>(ESS));}
 
 /** Sets the bucket type to `EAR`. */
-void HashTableBucket::makeEAR() {this->bucketType = EAR;}
+void HashTableBucket::makeEAR() {this->key.setState(static_cast<unsigned char>(EAR));}
 
 /** If the bucket is normal, this should return `false`. */
 bool HashTableBucket::isEmpty() const {
@@ -54,12 +76,12 @@ bool HashTableBucket::isEmpty() const {
 
 /** Returns `true` if the bucket type is set to `ESS`. */
 bool HashTableBucket::isEmptySinceStart() const {
-	return this->bucketType == ESS;
+	return this->bucketType() == ESS;
 }
 
 /** Returns `true` if the bucket type is set to `EAR`. */
 bool HashTableBucket::isEmptyAfterRemove() const {
-	return this->bucketType == EAR;
+	return this->bucketType() == EAR;
 }
 
 /**
@@ -70,9 +92,9 @@ bool HashTableBucket::isEmptyAfterRemove() const {
  *	The key-value pair can be represented as `<key, value>`. 
  */
 std::ostream & operator<<(std::ostream &os, const HashTableBucket &bucket) {
-	switch (bucket.bucketType) {
+	switch (bucket.bucketType()) {
 		case HashTableBucket::NORMAL: {
-			os << "<" << bucket.key << ", " << bucket.value << ">";
+			os << "<" << bucket.getKey() << ", " << bucket.value << ">";
 			break;
 		} case HashTableBucket::ESS: {
 			os << "ESS";
@@ -6,6 +6,17 @@
 #define HASHTABLEBUCKET_H
 
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include "HashTableKey.h"
+
+/**
+ *	Key storage used by `HashTableBucket`, chosen at compile time from
+ *	`HashTableKey.h`, e.g. `-DHASHTABLE_KEY_STORAGE=StringKey`.
+ */
+#ifndef HASHTABLE_KEY_STORAGE
+#define HASHTABLE_KEY_STORAGE InlineKey
+#endif
 
 class HashTableBucket {
 	private:
@@ -29,20 +40,29 @@ class HashTableBucket {
 			EAR
 		};
 
-		std::string key;
+	public:
+		using KeyStorage = HASHTABLE_KEY_STORAGE;
+
+	private:
+		KeyStorage key;
 		size_t value;
-		BucketType bucketType;
+		size_t hashCode;
+
+		BucketType bucketType() const;
 
 	public:
 		using enum BucketType;
 
 		HashTableBucket();
-		HashTableBucket(const std::string &key, const size_t &value);
+		HashTableBucket(std::string_view key, const size_t &value, size_t hashCode, StringArena &arena);
 
-		void load(const std::string &key, const size_t &value);
+		void load(std::string_view key, const size_t &value, size_t hashCode, StringArena &arena);
 
-		std::string getKey() const;
+		std::string_view getKey() const;
+		bool keyInArena() const;
+		size_t getHash() const;
 		size_t & valueOf();
+		const size_t & valueOf() const;
 
 		void makeNormal();
 		void makeESS();
@@ -55,4 +75,7 @@ class HashTableBucket {
 		friend std::ostream & operator<<(std::ostream &os, const HashTableBucket &bucket);
 };
 
+static_assert(!std::is_same_v<HashTableBucket::KeyStorage, InlineKey> || sizeof(HashTableBucket) <= 32,
+	"an InlineKey bucket should fit in 32 bytes");
+
 #endif
@@ -0,0 +1,127 @@
+/**
+ *	HashTableBucketImpl.h
+ *
+ *	Header-only, templated counterpart of `HashTableBucket`.
+ *	The key and value are stored by value inside the bucket, so trivially
+ *	copyable keys (integers, small POD records) never touch the heap.
+ *	Like `HashTableBucket`, it keeps the hash code of its key, so probes skip
+ *	key comparisons on other hash codes and rebuilds never hash a key again.
+ */
+
+#ifndef HASHTABLEBUCKETIMPL_H
+#define HASHTABLEBUCKETIMPL_H
+
+#include <ostream>
+#include <utility>
+
+template<typename Key, typename Value>
+class HashTableBucket_t {
+	private:
+		enum class BucketType : unsigned char {
+
+			/**
+			 *	The bucket is non-empty and currently storing a
+			 *	key-value pair.
+			 */
+			NORMAL,
+
+			/**
+			 *	The bucket has never had a key-value pair.
+			 */
+			ESS,
+
+			/**
+			 *	The bucket previously stored a key-value pair, but
+			 *	that pair was removed from the table.
+			 */
+			EAR
+		};
+
+		Key key{};
+		Value value{};
+		size_t hashCode = 0;
+		BucketType bucketType = BucketType::ESS;
+
+	public:
+		static constexpr BucketType NORMAL = BucketType::NORMAL;
+		static constexpr BucketType ESS = BucketType::ESS;
+		static constexpr BucketType EAR = BucketType::EAR;
+
+		/**
+		 *	The default constructor sets the bucket type to `ESS`
+		 *	(empty since start).
+		 */
+		HashTableBucket_t() = default;
+
+		/**
+		 *	Sets the bucket type to `NORMAL`, as well as initializing
+		 *	the key, value and hash code for this bucket.
+		 */
+		template<typename K, typename V>
+		HashTableBucket_t(K &&key, V &&value, size_t hashCode) {this->load(std::forward<K>(key), std::forward<V>(value), hashCode);}
+
+		/**
+		 *	A key-value pair and the hash code of its key are assigned to this
+		 *	bucket, which also sets the bucket type to `NORMAL`.
+		 */
+		template<typename K, typename V>
+		void load(K &&key, V &&value, size_t hashCode) {
+			this->makeNormal();
+			this->key = std::forward<K>(key);
+			this->value = std::forward<V>(value);
+			this->hashCode = hashCode;
+		}
+
+		/** Returns the key contained in this bucket. */
+		const Key & getKey() const {return this->key;}
+
+		/** Returns the hash code of the key contained in this bucket. */
+		size_t getHash() const {return this->hashCode;}
+
+		/**
+		 *	Returns a reference to a value in this bucket.
+		 *	The value of the bucket can be both accessed and mutated.
+		 */
+		Value & valueOf() {return this->value;}
+		const Value & valueOf() const {return this->value;}
+
+		/** Sets the bucket type to `NORMAL`. */
+		void makeNormal() {this->bucketType = NORMAL;}
+
+		/** Sets the bucket type to `ESS`. */
+		void makeESS() {this->bucketType = ESS;}
+
+		/** Sets the bucket type to `EAR`. */
+		void makeEAR() {this->bucketType = EAR;}
+
+		/** If the bucket is normal, this should return `false`. */
+		bool isEmpty() const {return this->bucketType != NORMAL;}
+
+		/** Returns `true` if the bucket type is set to `ESS`. */
+		bool isEmptySinceStart() const {return this->bucketType == ESS;}
+
+		/** Returns `true` if the bucket type is set to `EAR`. */
+		bool isEmptyAfterRemove() const {return this->bucketType == EAR;}
+
+		/**
+		 *	Prints a string representation of a bucket, `<key, value>` if it
+		 *	is normal, otherwise the bucket type.
+		 */
+		friend std::ostream & operator<<(std::ostream &os, const HashTableBucket_t &bucket) {
+			switch (bucket.bucketType) {
+				case NORMAL: {
+					os << "<" << bucket.key << ", " << bucket.value << ">";
+					break;
+				} case ESS: {
+					os << "ESS";
+					break;
+				} case EAR: {
+					os << "EAR";
+					break;
+				}
+			}
+			return os;
+		}
+};
+
+#endif
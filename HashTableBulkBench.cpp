@@ -0,0 +1,63 @@
+/**
+ *	HashTableBulkBench.cpp
+ *
+ *	Loads the same key set into a `HashTable` three ways: one `insert` per
+ *	key from the default capacity, one `insert` per key after `reserve`, and
+ *	one `insert_range` call. Every tenth key is repeated, so the duplicate
+ *	counts of the three loads can be compared.
+ *
+ *	Usage: `HashTableBulkBench [keys]`, default 10000000.
+ */
+
+#include "HashTable.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/** Returns seconds since `start`. */
+double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+	const size_t keyCount = (argc > 1) ? static_cast<size_t>(std::atoll(argv[1])) : 10000000;
+
+	std::mt19937_64 random(42);
+	std::vector<std::string> keys(keyCount);
+	for (size_t i = 0; i < keyCount; ++i) {keys[i] = (i % 10 == 9) ? keys[random() % i] : "key:" + std::to_string(random());}
+
+	std::vector<std::pair<std::string_view, size_t>> entries(keyCount);
+	for (size_t i = 0; i < keyCount; ++i) {entries[i] = {keys[i], i};}
+
+	std::printf("%zu pairs\n\n%-24s %10s %12s %10s\n", keyCount, "load", "seconds", "new keys", "capacity");
+
+	{
+		HashTable table;
+		size_t newKeys = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (const auto &[key, value] : entries) {newKeys += table.insert(key, value);}
+		std::printf("%-24s %10.3f %12zu %10zu\n", "insert", secondsSince(start), newKeys, table.capacity());
+	}
+	{
+		HashTable table;
+		size_t newKeys = 0;
+		const auto start = std::chrono::steady_clock::now();
+		table.reserve(keyCount);
+		for (const auto &[key, value] : entries) {newKeys += table.insert(key, value);}
+		std::printf("%-24s %10.3f %12zu %10zu\n", "reserve + insert", secondsSince(start), newKeys, table.capacity());
+	}
+	{
+		HashTable table;
+		const auto start = std::chrono::steady_clock::now();
+		const size_t newKeys = table.insert_range(entries);
+		std::printf("%-24s %10.3f %12zu %10zu\n", "insert_range", secondsSince(start), newKeys, table.capacity());
+	}
+
+	return 0;
+}
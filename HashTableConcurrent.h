@@ -0,0 +1,437 @@
+/**
+ *	HashTableConcurrent.h
+ *
+ *	Read-mostly concurrent hash table with the `insert`, `remove`, `contains`
+ *	and `get` API of the other tables.
+ *
+ *	-	Readers take no locks. They enter a read-side critical section of an
+ *		`EpochDomain`, load the current bucket array and probe it. Every
+ *		bucket is an atomic pointer to an immutable key with an atomic value.
+ *	-	Writers are serialized by one mutex. They publish new entries and new
+ *		bucket arrays with release stores, and retire removed entries and old
+ *		arrays to the epoch domain, which frees them once no reader can still
+ *		hold them.
+ *
+ *	Buckets are probed linearly in a power-of-two array; `nullptr` plays the
+ *	part of `ESS` and a shared marker the part of `EAR`.
+ */
+
+#ifndef HASHTABLECONCURRENT_H
+#define HASHTABLECONCURRENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "HashTableHash.h"
+#include "HashTableProbing.h"
+#include "HashTableGrowth.h"
+
+/**
+ *	Epoch-based reclamation with two reader phases, in the style of
+ *	user-space RCU. A reader counts itself into the current phase in one of
+ *	`STRIPES` cache-line-sized counters, picked per thread, so readers on
+ *	different cores never write the same cache line. A writer frees retired
+ *	memory by moving to the next phase and waiting for the counters of the
+ *	previous one to drain.
+ */
+class EpochDomain {
+	public:
+		static constexpr size_t STRIPES = 64;
+
+		/** Retired objects are freed in batches of this size. */
+		static constexpr size_t RETIRE_BATCH = 128;
+
+		/** Read-side critical section: retired memory stays valid while it is alive. */
+		class Guard {
+			public:
+				explicit Guard(const EpochDomain &domain) : counter(domain.enter()) {}
+				~Guard() {this->counter->fetch_sub(1, std::memory_order_release);}
+
+				Guard(const Guard &) = delete;
+				Guard & operator=(const Guard &) = delete;
+
+			private:
+				std::atomic<size_t> *counter;
+		};
+
+		EpochDomain() = default;
+		EpochDomain(const EpochDomain &) = delete;
+		EpochDomain & operator=(const EpochDomain &) = delete;
+
+		/** No reader may be left once the domain is destroyed. */
+		~EpochDomain() {this->freeRetired();}
+
+		/**
+		 *	Defers deleting `pointer` until every reader that might still see
+		 *	it has left. Must be called by one writer at a time.
+		 */
+		template<typename T>
+		void retire(T *pointer) {
+			this->retired.push_back(Retired{pointer, [](void *object) {delete static_cast<T *>(object);}});
+			if (this->retired.size() >= RETIRE_BATCH) {this->reclaim();}
+		}
+
+		/** Waits for the readers of the current phase, then frees everything retired so far. */
+		void reclaim() {
+			if (this->retired.empty()) {return;}
+
+			const uint64_t oldPhase = this->phase.load(std::memory_order_relaxed);
+			this->phase.store(oldPhase + 1, std::memory_order_seq_cst);
+			for (const Stripe &stripe : this->stripes) {
+				while (stripe.readers[oldPhase & 1].load(std::memory_order_seq_cst) != 0) {std::this_thread::yield();}
+			}
+
+			this->freeRetired();
+		}
+
+	private:
+		struct alignas(64) Stripe {
+			std::atomic<size_t> readers[2] = {0, 0};
+		};
+
+		struct Retired {
+			void *object;
+			void (*deleter)(void *);
+		};
+
+		mutable Stripe stripes[STRIPES];
+		std::atomic<uint64_t> phase{0};
+		std::vector<Retired> retired;
+
+		/** Each thread sticks to one stripe, handed out round robin. */
+		static size_t stripeIndex() {
+			static std::atomic<size_t> nextStripe{0};
+			thread_local const size_t index = nextStripe.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+			return index;
+		}
+
+		/**
+		 *	Counts the caller into the current phase. If a writer moved on to the
+		 *	next phase in between, the writer may have missed the count, so the
+		 *	reader retries in the new phase.
+		 */
+		std::atomic<size_t> * enter() const {
+			Stripe &stripe = this->stripes[stripeIndex()];
+			while (true) {
+				const uint64_t currentPhase = this->phase.load(std::memory_order_seq_cst);
+				std::atomic<size_t> &counter = stripe.readers[currentPhase & 1];
+				counter.fetch_add(1, std::memory_order_seq_cst);
+				if (this->phase.load(std::memory_order_seq_cst) == currentPhase) {return &counter;}
+				counter.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		void freeRetired() {
+			for (const Retired &object : this->retired) {object.deleter(object.object);}
+			this->retired.clear();
+		}
+};
+
+template<
+	typename Key,
+	typename Value,
+	typename Hash = typename DefaultHash<Key>::type,
+	typename Eq = typename DefaultEqual<Key>::type
+>
+class ConcurrentHashtable_t {
+	public:
+		static_assert(std::is_trivially_copyable_v<Value>, "values are stored in std::atomic");
+
+		using key_type = Key;
+		using mapped_type = Value;
+		using hasher = Hash;
+		using key_equal = Eq;
+
+		/** Default capacity for the hash table, matching `HashTable`. */
+		static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
+
+		/** `true` if both the hasher and the key equality declare `is_transparent`. */
+		static constexpr bool isTransparent = requires {
+			typename Hash::is_transparent;
+			typename Eq::is_transparent;
+		};
+
+		explicit ConcurrentHashtable_t(size_t initCapacity = DEFAULT_INITIAL_CAPACITY, const Hash &hash = Hash(), const Eq &equal = Eq())
+			: hash(hash), equal(equal) {
+			this->table.store(new Array(PowerOfTwoIndexing::roundCapacity(initCapacity)), std::memory_order_relaxed);
+			this->bucketCount.store(this->table.load(std::memory_order_relaxed)->capacity(), std::memory_order_relaxed);
+		}
+
+		ConcurrentHashtable_t(const ConcurrentHashtable_t &) = delete;
+		ConcurrentHashtable_t & operator=(const ConcurrentHashtable_t &) = delete;
+
+		/** No other thread may use the table while it is destroyed. */
+		~ConcurrentHashtable_t() {
+			Array *array = this->table.load(std::memory_order_relaxed);
+			for (size_t bucketIndex = 0; bucketIndex < array->capacity(); ++bucketIndex) {
+				Entry *entry = array->slots[bucketIndex].load(std::memory_order_relaxed);
+				if (isFull(entry)) {delete entry;}
+			}
+			delete array;
+		}
+
+		/**
+		 *	@brief Inserts a new key-value pair into the table.
+		 *
+		 *	Returns `true` if a unique key is inserted, `false` if the key was
+		 *	already present, in which case its value is overwritten.
+		 */
+		bool insert(const Key &key, const Value &value) {
+			std::lock_guard<std::mutex> lock(this->writer);
+			const auto [entry, inserted] = this->findOrInsert(key, this->hash(key), value);
+			if (!inserted) {entry->value.store(value, std::memory_order_release);}
+			return inserted;
+		}
+
+		/**
+		 *	@brief Atomically adds `delta` to the value of `key`, inserting the key
+		 *		with value `delta` if it is missing, and returns the value before
+		 *		the addition (`0` for a new key).
+		 *
+		 *	An existing key costs one lock-free probe and one atomic `fetch_add`
+		 *	on its value; only a missing key takes the writer lock.
+		 */
+		Value fetch_add(const Key &key, const Value &delta) requires std::is_integral_v<Value> {
+			const size_t keyHash = this->hash(key);
+			{
+				const EpochDomain::Guard guard(this->epochs);
+				if (Entry *entry = this->findEntry(key, keyHash)) {return entry->value.fetch_add(delta, std::memory_order_acq_rel);}
+			}
+
+			std::lock_guard<std::mutex> lock(this->writer);
+			const auto [entry, inserted] = this->findOrInsert(key, keyHash, delta);
+			return inserted ? Value{} : entry->value.fetch_add(delta, std::memory_order_acq_rel);
+		}
+
+		/**
+		 *	@brief Atomically replaces the value of `key` with `update(value)`,
+		 *		inserting the key with `update(Value{})` if it is missing.
+		 *
+		 *	An existing key is updated lock-free with a compare-and-swap loop, so
+		 *	`update` may run more than once and must have no side effects.
+		 *	Returns `true` if the key was inserted.
+		 */
+		template<typename Fn>
+		bool upsert(const Key &key, Fn &&update) {
+			const size_t keyHash = this->hash(key);
+			{
+				const EpochDomain::Guard guard(this->epochs);
+				if (Entry *entry = this->findEntry(key, keyHash)) {
+					apply(*entry, update);
+					return false;
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(this->writer);
+			const auto [entry, inserted] = this->findOrInsert(key, keyHash, update(Value{}));
+			if (!inserted) {apply(*entry, update);}
+			return inserted;
+		}
+
+		/**
+		 *	@brief Returns `true` if and only if a specified key exists in the table,
+		 *		in addition, removes that key in the table.
+		 */
+		bool remove(const Key &key) {
+			std::lock_guard<std::mutex> lock(this->writer);
+			Array &array = *this->table.load(std::memory_order_relaxed);
+			const auto [bucketIndex, entry] = this->find(array, key, this->hash(key));
+			if (entry == nullptr) {return false;}
+
+			array.slots[bucketIndex].store(tombstone(), std::memory_order_release);
+			++this->tombstones;
+			this->length.fetch_sub(1, std::memory_order_relaxed);
+			this->epochs.retire(entry);
+			return true;
+		}
+
+		/** @brief Returns `true` if and only if a specified key exists in the table. Takes no lock. */
+		bool contains(const Key &key) const {return this->lookup(key).has_value();}
+
+		template<typename K> requires isTransparent
+		bool contains(const K &key) const {return this->lookup(key).has_value();}
+
+		/**
+		 *	If the key is found in the table, return the value that is associated
+		 *	with that key. Otherwise, returns `nullopt`. Takes no lock.
+		 */
+		std::optional<Value> get(const Key &key) const {return this->lookup(key);}
+
+		template<typename K> requires isTransparent
+		std::optional<Value> get(const K &key) const {return this->lookup(key);}
+
+		/** Returns a vector of keys in the table, as seen by one reader. */
+		std::vector<Key> keys() const {
+			const EpochDomain::Guard guard(this->epochs);
+			const Array &array = *this->table.load(std::memory_order_acquire);
+
+			std::vector<Key> keyList;
+			for (size_t bucketIndex = 0; bucketIndex < array.capacity(); ++bucketIndex) {
+				const Entry *entry = array.slots[bucketIndex].load(std::memory_order_acquire);
+				if (isFull(entry)) {keyList.push_back(entry->key);}
+			}
+			return keyList;
+		}
+
+		/** Returns the load factor of the table, which is `size / capacity`. */
+		double alpha() const {
+			return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
+		}
+
+		/** Returns the number of buckets in the hash table. */
+		size_t capacity() const {return this->bucketCount.load(std::memory_order_relaxed);}
+
+		/** Returns the number of existing key-value pairs in the hash table. */
+		size_t size() const {return this->length.load(std::memory_order_relaxed);}
+
+	private:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		/** An immutable key with its hash code and an atomically updated value. */
+		struct Entry {
+			const Key key;
+			std::atomic<Value> value;
+			const size_t hash;
+
+			Entry(const Key &key, const Value &value, size_t hash) : key(key), value(value), hash(hash) {}
+		};
+
+		/** A bucket array. Only the writer stores into it, and only before it is retired. */
+		struct Array {
+			PowerOfTwoIndexing indexing;
+			std::unique_ptr<std::atomic<Entry *>[]> slots;
+
+			explicit Array(size_t capacity) : slots(new std::atomic<Entry *>[capacity]) {
+				this->indexing.reset(capacity);
+				for (size_t bucketIndex = 0; bucketIndex < capacity; ++bucketIndex) {
+					this->slots[bucketIndex].store(nullptr, std::memory_order_relaxed);
+				}
+			}
+
+			size_t capacity() const {return this->indexing.capacity();}
+		};
+
+		/** Never dereferenced; only its address marks a removed entry. */
+		static inline const char TOMBSTONE_MARKER = 0;
+
+		static Entry * tombstone() {return reinterpret_cast<Entry *>(const_cast<char *>(&TOMBSTONE_MARKER));}
+		static bool isFull(const Entry *entry) {return entry != nullptr && entry != tombstone();}
+
+		std::atomic<Array *> table;
+		std::atomic<size_t> bucketCount{0};
+		std::atomic<size_t> length{0};
+
+		mutable EpochDomain epochs;
+		std::mutex writer;
+		GrowthPolicy growth;
+		size_t tombstones = 0;
+
+		[[no_unique_address]] Hash hash;
+		[[no_unique_address]] Eq equal;
+
+		/**
+		 *	Returns the index of the bucket holding `key` in `array` and its
+		 *	entry, or `npos` and `nullptr`. The entry is the one whose key was
+		 *	compared: a writer may replace the bucket right after, so readers
+		 *	must not load it a second time.
+		 */
+		template<typename K>
+		std::pair<size_t, Entry *> find(const Array &array, const K &key, size_t keyHash) const {
+			for (size_t bucketIndex = array.indexing.home(keyHash);; bucketIndex = array.indexing.wrap(bucketIndex + 1)) {
+				Entry *entry = array.slots[bucketIndex].load(std::memory_order_acquire);
+				if (entry == nullptr) {return {npos, nullptr};}
+				if (entry != tombstone() && entry->hash == keyHash && this->equal(entry->key, key)) {return {bucketIndex, entry};}
+			}
+		}
+
+		/** Returns the entry of `key` in the current array, or `nullptr`. The caller holds a guard. */
+		template<typename K>
+		Entry * findEntry(const K &key, size_t keyHash) const {
+			return this->find(*this->table.load(std::memory_order_acquire), key, keyHash).second;
+		}
+
+		/** Replaces the value of `entry` with `update(value)` by compare-and-swap. */
+		template<typename Fn>
+		static void apply(Entry &entry, Fn &update) {
+			Value expected = entry.value.load(std::memory_order_acquire);
+			while (!entry.value.compare_exchange_weak(expected, update(expected), std::memory_order_acq_rel, std::memory_order_acquire)) {}
+		}
+
+		/**
+		 *	Writer body of `insert`, `fetch_add` and `upsert`; the caller holds
+		 *	the writer lock. Returns the entry of `key`, and `true` if the key was
+		 *	absent and has just been inserted with `value`. Entries never move,
+		 *	so the entry stays valid even if the insert rebuilds the array.
+		 */
+		std::pair<Entry *, bool> findOrInsert(const Key &key, size_t keyHash, const Value &value) {
+			Array &array = *this->table.load(std::memory_order_relaxed);
+
+			size_t freeIndex = npos;
+			for (size_t bucketIndex = array.indexing.home(keyHash);; bucketIndex = array.indexing.wrap(bucketIndex + 1)) {
+				Entry *entry = array.slots[bucketIndex].load(std::memory_order_relaxed);
+				if (entry == nullptr) {
+					if (freeIndex == npos) {freeIndex = bucketIndex;}
+					break;
+				} else if (entry == tombstone()) {
+					if (freeIndex == npos) {freeIndex = bucketIndex;}
+				} else if (entry->hash == keyHash && this->equal(entry->key, key)) {
+					return {entry, false};
+				}
+			}
+
+			Entry *entry = new Entry(key, value, keyHash);
+			if (array.slots[freeIndex].load(std::memory_order_relaxed) == tombstone()) {--this->tombstones;}
+			array.slots[freeIndex].store(entry, std::memory_order_release);
+			this->length.fetch_add(1, std::memory_order_relaxed);
+
+			const size_t newCapacity = this->growth.rebuildCapacity(this->size(), this->tombstones, array.capacity());
+			if (newCapacity > 0) {this->resize(newCapacity);}
+			return {entry, true};
+		}
+
+		/** Lock-free body of `contains` and `get`. */
+		template<typename K>
+		std::optional<Value> lookup(const K &key) const {
+			const size_t keyHash = this->hash(key);
+			const EpochDomain::Guard guard(this->epochs);
+			const Entry *entry = this->findEntry(key, keyHash);
+			if (entry == nullptr) {return std::nullopt;}
+			return entry->value.load(std::memory_order_acquire);
+		}
+
+		/**
+		 *	Copies every entry pointer into a new array of at least `newCapacity`
+		 *	buckets and publishes it. Readers still probing the old array see the
+		 *	same entries, so the old array is only retired, not freed.
+		 */
+		void resize(size_t newCapacity) {
+			Array *oldArray = this->table.load(std::memory_order_relaxed);
+			Array *newArray = new Array(PowerOfTwoIndexing::roundCapacity(newCapacity));
+
+			for (size_t oldIndex = 0; oldIndex < oldArray->capacity(); ++oldIndex) {
+				Entry *entry = oldArray->slots[oldIndex].load(std::memory_order_relaxed);
+				if (!isFull(entry)) {continue;}
+				size_t bucketIndex = newArray->indexing.home(entry->hash);
+				while (newArray->slots[bucketIndex].load(std::memory_order_relaxed) != nullptr) {
+					bucketIndex = newArray->indexing.wrap(bucketIndex + 1);
+				}
+				newArray->slots[bucketIndex].store(entry, std::memory_order_relaxed);
+			}
+
+			this->table.store(newArray, std::memory_order_release);
+			this->bucketCount.store(newArray->capacity(), std::memory_order_relaxed);
+			this->tombstones = 0;
+
+			// Old arrays are large, so they are freed right away instead of waiting for a full batch.
+			this->epochs.retire(oldArray);
+			this->epochs.reclaim();
+		}
+};
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ *	HashTableConcurrentTests.cpp
+ *
+ *	Narrated multithreaded stress test for `ConcurrentHashtable_t`.
+ *
+ *	-	Prints clear section headers and step-by-step narration, like
+ *		`HashTableTests.cpp`.
+ *	-	Each test ends with a SUCCESS/FAILURE summary line.
+ *
+ *	Usage: `HashTableConcurrentTests [threads]`, default is the hardware
+ *	concurrency.
+ */
+
+#include "HashTableConcurrent.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+using ConcurrentTable = ConcurrentHashtable_t<string, size_t>;
+
+#define OUTSTREAM cout
+
+/** Runs `body(threadIndex)` on `threads` threads and waits for all of them. */
+template<typename Body>
+void runThreads(size_t threads, Body body) {
+	vector<thread> workers;
+	for (size_t t = 0; t < threads; ++t) {workers.emplace_back(body, t);}
+	for (thread &worker : workers) {worker.join();}
+}
+
+int main(int argc, char **argv) {
+	const size_t THREADS = (argc > 1) ? static_cast<size_t>(atoi(argv[1])) : max(2u, thread::hardware_concurrency());
+	constexpr size_t STABLE_KEYS = 10000;
+	constexpr size_t CHURN_KEYS = 10000;
+
+	OUTSTREAM << "+=============================+" << endl;
+	OUTSTREAM << "| CONCURRENT HASH TABLE TESTS |" << endl;
+	OUTSTREAM << "+=============================+" << endl << endl;
+	OUTSTREAM << "Using " << THREADS << " threads." << endl << endl;
+
+	/**	=====================================================================
+	 *	SINGLE-THREADED API
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing insert/remove/contains/get on one thread" << endl;
+	OUTSTREAM << "------------------------------------------------" << endl << endl;
+	{
+		ConcurrentTable ht1;
+		bool ok = true;
+
+		OUTSTREAM << "Inserting 1000 keys, re-inserting them, then removing every other one..." << endl;
+		for (size_t i = 0; i < 1000; ++i) {ok &= ht1.insert("key" + to_string(i), i);}
+		for (size_t i = 0; i < 1000; ++i) {ok &= !ht1.insert("key" + to_string(i), i * 2);}
+		for (size_t i = 0; i < 1000; i += 2) {ok &= ht1.remove("key" + to_string(i));}
+		ok &= !ht1.remove("missing");
+
+		for (size_t i = 0; i < 1000; ++i) {
+			const optional<size_t> value = ht1.get("key" + to_string(i));
+			ok &= (i % 2 == 0) ? !value.has_value() : (value == i * 2);
+			ok &= ht1.contains("key" + to_string(i)) == (i % 2 == 1);
+		}
+		ok &= (ht1.size() == 500) && (ht1.keys().size() == 500);
+
+		OUTSTREAM << "  size() = " << ht1.size() << ", capacity() = " << ht1.capacity() << ", alpha() = " << ht1.alpha() << endl;
+		OUTSTREAM << (ok ? "SUCCESS: single-threaded results matched." : "FAILURE: single-threaded results mismatched.") << endl << endl;
+	}
+
+	/**	=====================================================================
+	 *	CONCURRENT INSERTS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing concurrent inserts of disjoint key ranges" << endl;
+	OUTSTREAM << "-------------------------------------------------" << endl << endl;
+	{
+		ConcurrentTable ht1;
+		atomic<bool> ok = true;
+
+		OUTSTREAM << "Each of " << THREADS << " threads inserts " << STABLE_KEYS << " keys..." << endl;
+		runThreads(THREADS, [&](size_t t) {
+			for (size_t i = 0; i < STABLE_KEYS; ++i) {
+				if (!ht1.insert(to_string(t) + ":" + to_string(i), i)) {ok = false;}
+			}
+		});
+
+		for (size_t t = 0; t < THREADS; ++t) {
+			for (size_t i = 0; i < STABLE_KEYS; ++i) {
+				if (ht1.get(to_string(t) + ":" + to_string(i)) != i) {ok = false;}
+			}
+		}
+		if (ht1.size() != THREADS * STABLE_KEYS) {ok = false;}
+
+		OUTSTREAM << "  size() = " << ht1.size() << ", capacity() = " << ht1.capacity() << endl;
+		OUTSTREAM << (ok ? "SUCCESS: every key was inserted exactly once." : "FAILURE: keys were lost or duplicated.") << endl << endl;
+	}
+
+	/**	=====================================================================
+	 *	CONCURRENT COUNTERS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing concurrent fetch_add and upsert on shared counters" << endl;
+	OUTSTREAM << "----------------------------------------------------------" << endl << endl;
+	{
+		ConcurrentTable ht1;
+		constexpr size_t COUNTERS = 1000, ROUNDS = 100;
+		bool ok = true;
+
+		OUTSTREAM << "Each of " << THREADS << " threads adds 1 to " << COUNTERS << " counters, " << ROUNDS << " times over, with fetch_add..." << endl;
+		OUTSTREAM << "  ...and adds 2 to one more counter each time with upsert." << endl;
+		runThreads(THREADS, [&](size_t) {
+			for (size_t round = 0; round < ROUNDS; ++round) {
+				for (size_t i = 0; i < COUNTERS; ++i) {ht1.fetch_add("counter" + to_string(i), 1);}
+				ht1.upsert("upserted", [](size_t count) {return count + 2;});
+			}
+		});
+
+		for (size_t i = 0; i < COUNTERS; ++i) {ok &= ht1.get("counter" + to_string(i)) == THREADS * ROUNDS;}
+		ok &= (ht1.get("upserted") == 2 * THREADS * ROUNDS) && (ht1.size() == COUNTERS + 1);
+
+		OUTSTREAM << "  counter0 = " << ht1.get("counter0").value_or(0) << ", upserted = " << ht1.get("upserted").value_or(0) << endl;
+		OUTSTREAM << (ok ? "SUCCESS: no increment was lost." : "FAILURE: increments were lost.") << endl << endl;
+	}
+
+	/**	=====================================================================
+	 *	READERS AGAINST WRITERS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing lock-free readers against writers that insert, remove and resize" << endl;
+	OUTSTREAM << "--------------------------------------------------------------------------" << endl << endl;
+	{
+		ConcurrentTable ht1;
+		atomic<bool> stop = false;
+		atomic<size_t> errors = 0, reads = 0;
+
+		OUTSTREAM << "Preloading " << STABLE_KEYS << " stable keys with value 2 * i..." << endl;
+		for (size_t i = 0; i < STABLE_KEYS; ++i) {ht1.insert("stable" + to_string(i), 2 * i);}
+
+		const size_t writers = max<size_t>(1, THREADS / 4);
+		const size_t readers = max<size_t>(1, THREADS - writers);
+		OUTSTREAM << "Running " << readers << " readers and " << writers << " writers for one second..." << endl;
+		OUTSTREAM << "  Readers expect every stable key with value 2 * i, and churn keys, if present, with value 3 * i." << endl;
+
+		vector<thread> workers;
+		for (size_t t = 0; t < writers; ++t) {
+			workers.emplace_back([&, t]() {
+				size_t round = 0;
+				while (!stop) {
+					for (size_t i = t; i < CHURN_KEYS; i += writers) {ht1.insert("churn" + to_string(i), 3 * i);}
+					for (size_t i = t; i < STABLE_KEYS; i += 97 * writers) {ht1.insert("stable" + to_string(i), 2 * i);}
+					for (size_t i = t; i < CHURN_KEYS; i += writers) {ht1.remove("churn" + to_string(i));}
+					++round;
+				}
+			});
+		}
+		for (size_t t = 0; t < readers; ++t) {
+			workers.emplace_back([&, t]() {
+				size_t localReads = 0, localErrors = 0;
+				for (size_t i = t; !stop; i = (i + 7919) % STABLE_KEYS) {
+					if (ht1.get("stable" + to_string(i)) != 2 * i) {++localErrors;}
+					const optional<size_t> churn = ht1.get("churn" + to_string(i % CHURN_KEYS));
+					if (churn && *churn != 3 * (i % CHURN_KEYS)) {++localErrors;}
+					localReads += 2;
+				}
+				reads += localReads;
+				errors += localErrors;
+			});
+		}
+
+		this_thread::sleep_for(chrono::seconds(1));
+		stop = true;
+		for (thread &worker : workers) {worker.join();}
+
+		const bool ok = (errors == 0) && (ht1.size() == STABLE_KEYS);
+		OUTSTREAM << "  " << reads << " reads, " << errors << " inconsistent results, final size() = " << ht1.size() << endl;
+		OUTSTREAM << (ok ? "SUCCESS: readers never saw a missing or torn entry." : "FAILURE: readers saw inconsistent entries.") << endl << endl;
+	}
+
+	/**	=====================================================================
+	 *	READ SCALING
+	 *	=====================================================================	*/
+	OUTSTREAM << "Measuring read throughput against reader count" << endl;
+	OUTSTREAM << "----------------------------------------------" << endl << endl;
+	{
+		ConcurrentTable ht1;
+		vector<string> keys;
+		for (size_t i = 0; i < STABLE_KEYS; ++i) {keys.push_back("stable" + to_string(i));}
+		for (size_t i = 0; i < STABLE_KEYS; ++i) {ht1.insert(keys[i], i);}
+
+		constexpr size_t READS_PER_THREAD = 2000000;
+		for (size_t readers = 1; readers <= THREADS; readers *= 2) {
+			atomic<size_t> found = 0;
+			const auto start = chrono::steady_clock::now();
+			runThreads(readers, [&](size_t t) {
+				size_t localFound = 0;
+				for (size_t i = 0, k = t; i < READS_PER_THREAD; ++i, k = (k + 7919) % STABLE_KEYS) {localFound += ht1.contains(keys[k]);}
+				found += localFound;
+			});
+			const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			OUTSTREAM << "  " << readers << " readers: " << static_cast<double>(readers * READS_PER_THREAD) / seconds / 1e6
+				<< " M reads/s" << (found == readers * READS_PER_THREAD ? "" : " (missing keys!)") << endl;
+		}
+		OUTSTREAM << "SUCCESS: throughput reported (manual inspection for scaling)." << endl << endl;
+	}
+
+	OUTSTREAM << "All tests complete." << endl;
+	return 0;
+}
@@ -0,0 +1,485 @@
+/**
+ *	HashTableFlat.h
+ *
+ *	Header-only hash table with a structure-of-arrays layout. Instead of one
+ *	`HashTableBucket` per slot, the table keeps three parallel arrays:
+ *	-	one control byte per bucket, which is either `EMPTY` (`ESS`),
+ *		`DELETED` (`EAR`) or a 7-bit fragment of the key's hash (`NORMAL`),
+ *	-	the keys,
+ *	-	the values.
+ *
+ *	A probe reads the dense control bytes first and only touches key memory
+ *	when the hash fragment matches, so most negative lookups never load a key.
+ *
+ *	With `GroupProbing` (the default) each probe compares a whole group of
+ *	16 or 32 control bytes at once with SSE2/AVX2, or 8 with portable SWAR;
+ *	any other strategy from `HashTableProbing.h` probes one bucket at a time.
+ */
+
+#ifndef HASHTABLEFLAT_H
+#define HASHTABLEFLAT_H
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include "HashTableHash.h"
+#include "HashTableProbing.h"
+#include "HashTableGrowth.h"
+#include "HashTableGroup.h"
+
+/** Control byte values. Normal buckets store a hash fragment in `[0, 127]`. */
+namespace Control {
+	constexpr int8_t EMPTY = -128;
+	constexpr int8_t DELETED = -2;
+
+	/** Returns `true` for a control byte of a normal bucket. */
+	constexpr bool isFull(int8_t control) {return control >= 0;}
+
+	/**
+	 *	Returns the 7-bit hash fragment stored in the control byte. It uses
+	 *	the top bits of the finalized hash, which the indexing strategies do
+	 *	not use for the home bucket.
+	 */
+	inline int8_t fragment(size_t hash) {return static_cast<int8_t>(mixHash(hash) >> 57);}
+}
+
+template<
+	typename Key,
+	typename Value,
+	typename Hash = typename DefaultHash<Key>::type,
+	typename Eq = typename DefaultEqual<Key>::type,
+	typename Probing = GroupProbing,
+	typename Indexing = PowerOfTwoIndexing
+>
+class FlatHashtable_t {
+	public:
+		using key_type = Key;
+		using mapped_type = Value;
+		using hasher = Hash;
+		using key_equal = Eq;
+		using probing_type = Probing;
+		using indexing_type = Indexing;
+
+		static_assert(!Probing::requiresPowerOfTwo || Indexing::powerOfTwo, "probing strategy needs a power-of-two capacity");
+
+		/** `true` if the probing strategy inspects a group of control bytes per probe. */
+		static constexpr bool grouped = requires {Probing::grouped;};
+
+		/** `true` if lookups accept any type the hasher and key equality take. */
+		static constexpr bool isTransparent = requires {
+			typename Hash::is_transparent;
+			typename Eq::is_transparent;
+		};
+
+		/** Default capacity for the hash table, matching `HashTable`. */
+		static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
+
+		/**
+		 *	The internal capacity of the hash table is set to the initial
+		 *	capacity, if specified. Default is 8.
+		 */
+		explicit FlatHashtable_t(size_t initCapacity = DEFAULT_INITIAL_CAPACITY, const Hash &hash = Hash(), const Eq &equal = Eq())
+			: length(0), tombstones(0), hash(hash), equal(equal) {
+			this->allocate(Indexing::roundCapacity(initCapacity));
+		}
+
+		/**
+		 *	@brief Inserts a new key-value pair into the table.
+		 *
+		 *	Returns `true` if a unique key is inserted, `false` if the key was
+		 *	already present, in which case its value is overwritten.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		bool insert(const Key &key, const Value &value) {return this->emplace(key, value);}
+		bool insert(Key &&key, Value &&value) {return this->emplace(std::move(key), std::move(value));}
+
+		/**
+		 *	@brief Returns `true` if and only if a specified key exists in the table,
+		 *		in addition, removes that key in the table.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		bool remove(const Key &key) {return this->erase(key);}
+
+		template<typename K> requires isTransparent
+		bool remove(const K &key) {return this->erase(key);}
+
+		/**
+		 *	@brief Returns `true` if and only if a specified key exists in the table.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		bool contains(const Key &key) const {return this->find(key).index != npos;}
+
+		template<typename K> requires isTransparent
+		bool contains(const K &key) const {return this->find(key).index != npos;}
+
+		/**
+		 *	If the key is found in the table, return the value that is associated
+		 *	with that key. Otherwise, returns `nullopt`.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		std::optional<Value> get(const Key &key) const {return this->lookup(key);}
+
+		template<typename K> requires isTransparent
+		std::optional<Value> get(const K &key) const {return this->lookup(key);}
+
+		/**
+		 *	Looks up every key of `keys` and stores its value, or `nullopt`, at
+		 *	the same index of `results`, which must hold at least `keys.size()`
+		 *	entries. Like `HashTable::get_many`, each batch of keys is hashed and
+		 *	the control bytes and first key of every home bucket are prefetched
+		 *	before the batch is probed.
+		 */
+		void get_many(std::span<const Key> keys, std::span<std::optional<Value>> results) const {
+			this->lookupMany(keys, [&results](size_t keyIndex, const std::optional<Value> &value) {results[keyIndex] = value;}, results.size());
+		}
+
+		template<typename K> requires isTransparent
+		void get_many(std::span<const K> keys, std::span<std::optional<Value>> results) const {
+			this->lookupMany(keys, [&results](size_t keyIndex, const std::optional<Value> &value) {results[keyIndex] = value;}, results.size());
+		}
+
+		/** Like `get_many`, but stores whether each key exists in the table. */
+		void contains_many(std::span<const Key> keys, std::span<bool> results) const {
+			this->lookupMany(keys, [&results](size_t keyIndex, const std::optional<Value> &value) {results[keyIndex] = value.has_value();}, results.size());
+		}
+
+		template<typename K> requires isTransparent
+		void contains_many(std::span<const K> keys, std::span<bool> results) const {
+			this->lookupMany(keys, [&results](size_t keyIndex, const std::optional<Value> &value) {results[keyIndex] = value.has_value();}, results.size());
+		}
+
+		/**
+		 *	Returns a reference to the value associated with the specified key.
+		 *	If a key is not found in the table, it is inserted with a
+		 *	value-initialized value first, like `HashTable::operator[]`, in the
+		 *	same probe.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		Value & operator[](const Key &key) {return this->valueData[this->findOrInsert(key).first];}
+
+		/**
+		 *	Returns the number of probes a lookup of `key` takes: buckets for
+		 *	one-bucket-at-a-time strategies, groups for `GroupProbing`.
+		 */
+		template<typename K = Key>
+		size_t probeLength(const K &key) const {return this->find(key).length;}
+
+		/** Returns a vector of keys that are currently in the table. */
+		std::vector<Key> keys() const {
+			std::vector<Key> keyList;
+			keyList.reserve(this->size());
+
+			for (size_t bucketIndex = 0; bucketIndex < this->capacity(); ++bucketIndex) {
+				if (Control::isFull(this->controlData[bucketIndex])) {keyList.push_back(this->keyData[bucketIndex]);}
+			}
+
+			return keyList;
+		}
+
+		/** Returns the load factor of the table, which is `size / capacity`. */
+		double alpha() const {
+			return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
+		}
+
+		/** Returns the load factor at which the table grows. Default is 0.5. */
+		double max_load_factor() const {return this->growth.maxLoadFactor;}
+
+		/**
+		 *	Sets the load factor at which the table grows, which must lie in `(0, 1)`.
+		 *	If the table is already past it, the table is rehashed right away.
+		 */
+		void max_load_factor(double maxLoadFactor) {
+			this->growth.setMaxLoadFactor(maxLoadFactor);
+			if (this->growth.exceeds(this->size(), this->capacity())) {this->rehash(0);}
+		}
+
+		/** Returns the factor the capacity is multiplied by on growth. Default is 2. */
+		double growth_factor() const {return this->growth.growthFactor;}
+
+		/** Sets the factor the capacity is multiplied by on growth, which must be greater than 1. */
+		void growth_factor(double growthFactor) {this->growth.setGrowthFactor(growthFactor);}
+
+		/**
+		 *	Makes room for `count` entries, so inserting up to `count` keys does a
+		 *	single allocation here and no resize afterwards.
+		 */
+		void reserve(size_t count) {
+			if (this->growth.bucketsFor(count) > this->capacity()) {this->resize(this->growth.bucketsFor(count));}
+		}
+
+		/**
+		 *	Rebuilds the table with at least `count` buckets, and at least enough to
+		 *	keep the current entries below the max load factor.
+		 */
+		void rehash(size_t count) {
+			this->resize(std::max(count, this->growth.bucketsFor(this->size())));
+		}
+
+		/** Returns the number of buckets in the hash table. */
+		size_t capacity() const {return this->keyData.size();}
+
+		/** Returns the number of existing key-value pairs in the hash table. */
+		size_t size() const {return this->length;}
+
+		/** Returns the number of `DELETED` buckets, which still lengthen probe sequences. */
+		size_t tombstoneCount() const {return this->tombstones;}
+
+		/**
+		 *	Prints all normal buckets of the table as
+		 *	`[0: <key0, value0>, 1: <key1, value1>, ...]`.
+		 */
+		friend std::ostream & operator<<(std::ostream &os, const FlatHashtable_t &hashTable) {
+			size_t printedBuckets = 0;
+			os << "[";
+			for (size_t bucketIndex = 0; bucketIndex < hashTable.capacity(); ++bucketIndex) {
+				if (Control::isFull(hashTable.controlData[bucketIndex])) {
+					if (printedBuckets > 0) {os << ", ";}
+					os << bucketIndex << ": <" << hashTable.keyData[bucketIndex] << ", " << hashTable.valueData[bucketIndex] << ">";
+					++printedBuckets;
+				}
+			}
+			os << "]";
+			return os;
+		}
+
+	private:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		/** Buckets per probe, and the control bytes cloned past the end for group loads. */
+		static constexpr size_t groupWidth() {
+			if constexpr (grouped) {return Probing::WIDTH;}
+			else {return 1;}
+		}
+
+		static constexpr size_t CLONED = groupWidth() - 1;
+
+		/**
+		 *	Outcome of a lookup: the bucket holding the key (or `npos`), the
+		 *	`EMPTY` bucket where the probes stopped, and the number of probes.
+		 */
+		struct ProbeResult {
+			size_t index;
+			size_t stop;
+			size_t length;
+		};
+
+		Indexing indexing;
+		Probing probing;
+		GrowthPolicy growth;
+
+		std::vector<int8_t> controlData;
+		std::vector<Key> keyData;
+		std::vector<Value> valueData;
+
+		size_t length;
+		size_t tombstones;
+
+		[[no_unique_address]] Hash hash;
+		[[no_unique_address]] Eq equal;
+
+		/**
+		 *	Replaces all three arrays with `capacity` empty buckets. Grouped
+		 *	probing needs at least one whole group.
+		 */
+		void allocate(size_t capacity) {
+			if (capacity < groupWidth()) {capacity = groupWidth();}
+			this->indexing.reset(capacity);
+			this->probing.reset(capacity);
+			this->controlData.assign(capacity + CLONED, Control::EMPTY);
+			this->tombstones = 0;
+			this->keyData = std::vector<Key>(capacity);
+			this->valueData = std::vector<Value>(capacity);
+		}
+
+		/** Sets a control byte, and its clone past the end if it has one. */
+		void setControl(size_t bucketIndex, int8_t control) {
+			this->controlData[bucketIndex] = control;
+			if (bucketIndex < CLONED) {this->controlData[bucketIndex + this->capacity()] = control;}
+		}
+
+		/**
+		 *	Looks up `key`. Only buckets whose control byte equals the key's
+		 *	hash fragment have their key compared; the probes stop at the first
+		 *	probe that sees an `EMPTY` control byte.
+		 */
+		template<typename K>
+		ProbeResult find(const K &key) const {return this->find(key, this->hash(key));}
+
+		template<typename K>
+		ProbeResult find(const K &key, size_t keyHash) const {
+			const int8_t fragment = Control::fragment(keyHash);
+			ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
+			while (true) {
+				if constexpr (grouped) {
+					const typename Probing::GroupKind group(&this->controlData[probe.index]);
+					for (auto match = group.match(fragment); match; match.next()) {
+						const size_t bucketIndex = this->indexing.wrap(probe.index + match.lowest());
+						if (this->equal(this->keyData[bucketIndex], key)) {return ProbeResult{bucketIndex, npos, probe.probe + 1};}
+					}
+					if (const auto empty = group.matchEmpty()) {
+						return ProbeResult{npos, this->indexing.wrap(probe.index + empty.lowest()), probe.probe + 1};
+					}
+				} else {
+					const int8_t control = this->controlData[probe.index];
+					if (control == Control::EMPTY) {return ProbeResult{npos, probe.index, probe.probe + 1};}
+					if (control == fragment && this->equal(this->keyData[probe.index], key)) {
+						return ProbeResult{probe.index, npos, probe.probe + 1};
+					}
+				}
+				this->probing.advance(probe, this->indexing);
+			}
+		}
+
+		/** Returns the first `EMPTY` or `DELETED` bucket along the probe sequence of `keyHash`. */
+		size_t findFree(size_t keyHash) const {
+			ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
+			while (true) {
+				if constexpr (grouped) {
+					const typename Probing::GroupKind group(&this->controlData[probe.index]);
+					if (const auto free = group.matchEmptyOrDeleted()) {return this->indexing.wrap(probe.index + free.lowest());}
+				} else {
+					if (!Control::isFull(this->controlData[probe.index])) {return probe.index;}
+				}
+				this->probing.advance(probe, this->indexing);
+			}
+		}
+
+		/** Shared body of `get_many` and `contains_many`: calls `store(keyIndex, value)` for every key. */
+		template<typename K, typename Store>
+		void lookupMany(std::span<const K> keys, Store store, size_t resultCount) const {
+			if (resultCount < keys.size()) {throw std::invalid_argument("batched lookups need one result per key");}
+
+			size_t hashes[PREFETCH_BATCH];
+			for (size_t first = 0; first < keys.size(); first += PREFETCH_BATCH) {
+				const size_t batchSize = std::min(PREFETCH_BATCH, keys.size() - first);
+				for (size_t i = 0; i < batchSize; ++i) {
+					hashes[i] = this->hash(keys[first + i]);
+					const size_t home = this->probing.begin(hashes[i], this->indexing).index;
+					prefetch(&this->controlData[home]);
+					prefetch(&this->keyData[home]);
+				}
+				for (size_t i = 0; i < batchSize; ++i) {
+					const size_t bucketIndex = this->find(keys[first + i], hashes[i]).index;
+					store(first + i, (bucketIndex != npos) ? std::optional<Value>(this->valueData[bucketIndex]) : std::nullopt);
+				}
+			}
+		}
+
+		/** Shared body of both `get` overloads. */
+		template<typename K>
+		std::optional<Value> lookup(const K &key) const {
+			const size_t bucketIndex = this->find(key).index;
+			if (bucketIndex == npos) {return std::nullopt;}
+			return std::optional<Value>(this->valueData[bucketIndex]);
+		}
+
+		/**
+		 *	Shared body of both `remove` overloads. Found buckets become `DELETED`,
+		 *	unless a scalar probing strategy asks for backward-shift deletion.
+		 */
+		template<typename K>
+		bool erase(const K &key) {
+			const size_t bucketIndex = this->find(key).index;
+			if (bucketIndex == npos) {return false;}
+			if constexpr (!grouped && usesBackwardShift<Probing>) {
+				this->shiftBack(bucketIndex);
+			} else {
+				this->setControl(bucketIndex, Control::DELETED);
+				++this->tombstones;
+			}
+			--this->length;
+			return true;
+		}
+
+		/**
+		 *	Moves later entries of the cluster after `hole` back into the gap,
+		 *	skipping those whose home bucket lies between the gap and themselves.
+		 *	The last gap becomes `EMPTY`.
+		 */
+		void shiftBack(size_t hole) {
+			size_t bucketIndex = hole;
+			while (true) {
+				bucketIndex = this->indexing.wrap(bucketIndex + 1);
+				const int8_t control = this->controlData[bucketIndex];
+				if (control == Control::EMPTY) {break;}
+				if (cyclicallyBetween(hole, this->indexing.home(this->hash(this->keyData[bucketIndex])), bucketIndex)) {continue;}
+				this->setControl(hole, control);
+				this->keyData[hole] = std::move(this->keyData[bucketIndex]);
+				this->valueData[hole] = std::move(this->valueData[bucketIndex]);
+				hole = bucketIndex;
+			}
+			this->setControl(hole, Control::EMPTY);
+		}
+
+		/** Shared body of both `insert` overloads. */
+		template<typename K, typename V>
+		bool emplace(K &&key, V &&value) {
+			const auto [bucketIndex, inserted] = this->findOrInsert(std::forward<K>(key));
+			this->valueData[bucketIndex] = std::forward<V>(value);
+			return inserted;
+		}
+
+		/**
+		 *	Shared probe of `insert` and `operator[]`. Returns the index of the
+		 *	bucket holding `key`, and `true` if the key was absent and has just
+		 *	been inserted with a value-initialized value.
+		 *
+		 *	The key is hashed once. A new key takes the first `DELETED` or
+		 *	`EMPTY` bucket along its probe sequence, which is where the lookup
+		 *	stopped unless there are `DELETED` buckets. If the new key would
+		 *	reach the max load factor, the table is rebuilt before the key is
+		 *	placed, so the returned index stays valid.
+		 */
+		template<typename K>
+		std::pair<size_t, bool> findOrInsert(K &&key) {
+			const size_t keyHash = this->hash(key);
+			const ProbeResult found = this->find(key, keyHash);
+			if (found.index != npos) {return {found.index, false};}
+
+			size_t freeIndex = (this->tombstones == 0) ? found.stop : this->findFree(keyHash);
+			const size_t tombstonesAfter = this->tombstones - ((this->controlData[freeIndex] == Control::DELETED) ? 1 : 0);
+			const size_t newCapacity = this->growth.rebuildCapacity(this->size() + 1, tombstonesAfter, this->capacity());
+			if (newCapacity > 0) {
+				this->resize(newCapacity);
+				freeIndex = this->findFree(keyHash);
+			}
+
+			if (this->controlData[freeIndex] == Control::DELETED) {--this->tombstones;}
+			this->setControl(freeIndex, Control::fragment(keyHash));
+			this->keyData[freeIndex] = std::forward<K>(key);
+			this->valueData[freeIndex] = Value{};
+			++this->length;
+			return {freeIndex, true};
+		}
+
+		/**
+		 *	Changes the capacity to at least `newCapacity` and moves every normal
+		 *	bucket into its bucket index in the new arrays, dropping every `DELETED` bucket.
+		 */
+		void resize(size_t newCapacity) {
+			std::vector<int8_t> oldControlData = std::move(this->controlData);
+			std::vector<Key> oldKeyData = std::move(this->keyData);
+			std::vector<Value> oldValueData = std::move(this->valueData);
+			this->allocate(Indexing::roundCapacity(newCapacity));
+
+			for (size_t oldIndex = 0; oldIndex < oldKeyData.size(); ++oldIndex) {
+				if (!Control::isFull(oldControlData[oldIndex])) {continue;}
+				const size_t bucketIndex = this->findFree(this->hash(oldKeyData[oldIndex]));
+				this->setControl(bucketIndex, oldControlData[oldIndex]);
+				this->keyData[bucketIndex] = std::move(oldKeyData[oldIndex]);
+				this->valueData[bucketIndex] = std::move(oldValueData[oldIndex]);
+			}
+		}
+};
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ *	HashTableGroup.h
+ *
+ *	Group probing over control bytes for `FlatHashtable_t`. A group is a run
+ *	of consecutive control bytes that is compared against a hash fragment in
+ *	a handful of instructions, instead of one bucket per loop iteration:
+ *	-	`GroupAvx2`: 32 bytes per group with AVX2 (`-mavx2`).
+ *	-	`GroupSse2`: 16 bytes per group with SSE2, the x86-64 baseline.
+ *	-	`GroupPortable`: 8 bytes per group with SWAR on a `uint64_t`.
+ *
+ *	`Group` is the widest one the target supports, unless `HASHTABLE_GROUP`
+ *	names one explicitly.
+ */
+
+#ifndef HASHTABLEGROUP_H
+#define HASHTABLEGROUP_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include "HashTableProbing.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define HASHTABLE_HAVE_SSE2 1
+#endif
+
+/**
+ *	Matching lanes of a group, lowest lane first. `SHIFT` converts a bit
+ *	position into a lane: SIMD masks have one bit per lane, SWAR masks have
+ *	the top bit of each byte.
+ */
+template<unsigned SHIFT>
+class GroupMask {
+	public:
+		explicit GroupMask(uint64_t bits) : bits(bits) {}
+
+		explicit operator bool() const {return this->bits != 0;}
+
+		/** Returns the lowest matching lane. */
+		unsigned lowest() const {return static_cast<unsigned>(std::countr_zero(this->bits)) >> SHIFT;}
+
+		/** Drops the lowest matching lane. */
+		void next() {this->bits &= this->bits - 1;}
+
+	private:
+		uint64_t bits;
+};
+
+#ifdef HASHTABLE_HAVE_SSE2
+/** 16 control bytes compared with SSE2 `pcmpeqb` and `pmovmskb`. */
+class GroupSse2 {
+	public:
+		static constexpr size_t WIDTH = 16;
+		using Mask = GroupMask<0>;
+
+		explicit GroupSse2(const int8_t *controls)
+			: controls(_mm_loadu_si128(reinterpret_cast<const __m128i *>(controls))) {}
+
+		/** Lanes whose control byte equals `fragment`. */
+		Mask match(int8_t fragment) const {
+			return Mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(fragment), this->controls))));
+		}
+
+		/** Lanes that are `EMPTY` (-128). */
+		Mask matchEmpty() const {return this->match(-128);}
+
+		/** Lanes that are `EMPTY` or `DELETED`, i.e. below -1. */
+		Mask matchEmptyOrDeleted() const {
+			return Mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), this->controls))));
+		}
+
+	private:
+		__m128i controls;
+};
+#endif
+
+#ifdef __AVX2__
+/** 32 control bytes compared with AVX2 `vpcmpeqb` and `vpmovmskb`. */
+class GroupAvx2 {
+	public:
+		static constexpr size_t WIDTH = 32;
+		using Mask = GroupMask<0>;
+
+		explicit GroupAvx2(const int8_t *controls)
+			: controls(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(controls))) {}
+
+		Mask match(int8_t fragment) const {
+			return Mask(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(fragment), this->controls))));
+		}
+
+		Mask matchEmpty() const {return this->match(-128);}
+
+		Mask matchEmptyOrDeleted() const {
+			return Mask(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-1), this->controls))));
+		}
+
+	private:
+		__m256i controls;
+};
+#endif
+
+/**
+ *	8 control bytes compared as one `uint64_t` (SWAR). `match` may report a
+ *	false positive in the lane above a true match; callers compare keys
+ *	anyway, so that only costs an extra comparison.
+ */
+class GroupPortable {
+	public:
+		static constexpr size_t WIDTH = 8;
+		using Mask = GroupMask<3>;
+
+		explicit GroupPortable(const int8_t *controls) {
+			std::memcpy(&this->controls, controls, sizeof(this->controls));
+			if constexpr (std::endian::native == std::endian::big) {this->controls = byteswap(this->controls);}
+		}
+
+		Mask match(int8_t fragment) const {
+			const uint64_t x = this->controls ^ (LSBS * static_cast<uint8_t>(fragment));
+			return Mask((x - LSBS) & ~x & MSBS);
+		}
+
+		/** `EMPTY` is the only control byte with the top bit set and bit 1 clear. */
+		Mask matchEmpty() const {return Mask(this->controls & ~(this->controls << 6) & MSBS);}
+
+		/** `EMPTY` and `DELETED` are the control bytes with the top bit set and bit 0 clear. */
+		Mask matchEmptyOrDeleted() const {return Mask(this->controls & ~(this->controls << 7) & MSBS);}
+
+	private:
+		static constexpr uint64_t LSBS = 0x0101010101010101ULL;
+		static constexpr uint64_t MSBS = 0x8080808080808080ULL;
+
+		uint64_t controls;
+
+		static uint64_t byteswap(uint64_t x) {
+			uint64_t y = 0;
+			for (int i = 0; i < 8; ++i) {y = (y << 8) | ((x >> (8 * i)) & 0xff);}
+			return y;
+		}
+};
+
+#ifndef HASHTABLE_GROUP
+#if defined(__AVX2__)
+#define HASHTABLE_GROUP GroupAvx2
+#elif defined(HASHTABLE_HAVE_SSE2)
+#define HASHTABLE_GROUP GroupSse2
+#else
+#define HASHTABLE_GROUP GroupPortable
+#endif
+#endif
+
+using Group = HASHTABLE_GROUP;
+
+/**
+ *	Probing strategy for `FlatHashtable_t` that inspects a whole `Group` of
+ *	control bytes per probe. Groups start at the home bucket and advance
+ *	by `WIDTH, 2 * WIDTH, 3 * WIDTH, ...` buckets (triangular over groups),
+ *	which visits every group of a power-of-two capacity.
+ *
+ *	The table keeps a copy of its first `WIDTH - 1` control bytes past the
+ *	end, so a group starting near the end can be loaded without wrapping.
+ */
+template<typename GroupType = Group>
+struct GroupProbing_t {
+	using GroupKind = GroupType;
+
+	static constexpr bool requiresPowerOfTwo = true;
+	static constexpr bool grouped = true;
+	static constexpr size_t WIDTH = GroupType::WIDTH;
+
+	void reset(size_t) {}
+
+	template<typename Indexing>
+	ProbeCursor begin(size_t hash, const Indexing &indexing) const {
+		const size_t home = indexing.home(hash);
+		return ProbeCursor{home, home, 0, 0};
+	}
+
+	template<typename Indexing>
+	void advance(ProbeCursor &cursor, const Indexing &indexing) const {
+		++cursor.probe;
+		cursor.step += WIDTH;
+		cursor.index = indexing.wrap(cursor.index + (cursor.step & (indexing.capacity() - 1)));
+	}
+};
+
+using GroupProbing = GroupProbing_t<>;
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ *	HashTableGrowth.h
+ *
+ *	Load factor and growth settings shared by the tables, in the style of
+ *	`std::unordered_map::max_load_factor`.
+ */
+
+#ifndef HASHTABLEGROWTH_H
+#define HASHTABLEGROWTH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+struct GrowthPolicy {
+
+	/**
+	 *	The table grows once `size / capacity` reaches this value. It must lie
+	 *	in `(0, 1)`, so the probe sequence of a missing key always ends.
+	 */
+	double maxLoadFactor = 0.5;
+
+	/** The capacity is multiplied by this value whenever the table grows. */
+	double growthFactor = 2.0;
+
+	/** Throws `std::invalid_argument` unless `0 < maxLoadFactor < 1`. */
+	void setMaxLoadFactor(double maxLoadFactor) {
+		if (!(maxLoadFactor > 0.0 && maxLoadFactor < 1.0)) {
+			throw std::invalid_argument("max_load_factor must lie in (0, 1)");
+		}
+		this->maxLoadFactor = maxLoadFactor;
+	}
+
+	/** Throws `std::invalid_argument` unless `growthFactor > 1`. */
+	void setGrowthFactor(double growthFactor) {
+		if (!(growthFactor > 1.0)) {
+			throw std::invalid_argument("growth_factor must be greater than 1");
+		}
+		this->growthFactor = growthFactor;
+	}
+
+	/** Returns `true` if `size` entries in `capacity` buckets reach the max load factor. */
+	bool exceeds(size_t size, size_t capacity) const {
+		return static_cast<double>(size) >= this->maxLoadFactor * static_cast<double>(capacity);
+	}
+
+	/** Returns the most entries `capacity` buckets hold below the max load factor. */
+	size_t entriesBelow(size_t capacity) const {
+		const size_t limit = static_cast<size_t>(std::ceil(this->maxLoadFactor * static_cast<double>(capacity)));
+		return (limit > 0) ? limit - 1 : 0;
+	}
+
+	/** Returns the fewest buckets that hold `size` entries below the max load factor. */
+	size_t bucketsFor(size_t size) const {
+		return static_cast<size_t>(std::floor(static_cast<double>(size) / this->maxLoadFactor)) + 1;
+	}
+
+	/**
+	 *	Returns the capacity to rebuild the table with once the live entries
+	 *	and `EAR` tombstones together reach the max load factor, or `0` while
+	 *	they are below it. The table only grows if the live entries fill at
+	 *	least half of that threshold; otherwise rebuilding at the current
+	 *	capacity is enough to clear the tombstones.
+	 */
+	size_t rebuildCapacity(size_t size, size_t tombstones, size_t capacity) const {
+		if (!this->exceeds(size + tombstones, capacity)) {return 0;}
+		return this->exceeds(2 * size, capacity) ? this->grow(capacity) : capacity;
+	}
+
+	/** Returns the capacity after growing from `capacity`, always at least one more bucket. */
+	size_t grow(size_t capacity) const {
+		const size_t grown = static_cast<size_t>(std::ceil(static_cast<double>(capacity) * this->growthFactor));
+		return std::max(grown, capacity + 1);
+	}
+};
+
+#endif
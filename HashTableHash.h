@@ -0,0 +1,410 @@
+/**
+ *	HashTableHash.h
+ *
+ *	Hashers and key equalities shared by the tables. `StringHash` is
+ *	`std::hash`; `SipHash` is keyed for untrusted keys; `WyHash`, `AesHash`
+ *	and `Crc32cHash` trade that for speed, the last two using AES-NI and
+ *	SSE4.2 where the CPU has them.
+ *
+ *	A string hasher usable as the key hash of `HashTable` also provides:
+ *	-	`seeded`: `true` if the hash codes depend on a secret seed.
+ *	-	A constructor from a 64-bit seed, which an unseeded hasher ignores.
+ *	-	`seed()`: the seed, or `0` for an unseeded hasher.
+ */
+
+#ifndef HASHTABLEHASH_H
+#define HASHTABLEHASH_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+
+/**
+ *	Transparent string hasher. Every string-like argument is hashed as a
+ *	`std::string_view`, which the standard guarantees to agree with
+ *	`std::hash<std::string>`, so lookups never have to build a `std::string`.
+ *
+ *	`std::hash` takes no seed, so the hash codes are the same in every
+ *	process and colliding keys can be computed ahead of time.
+ */
+struct StringHash {
+	using is_transparent = void;
+
+	static constexpr bool seeded = false;
+
+	StringHash() = default;
+	explicit StringHash(uint64_t) {}
+
+	size_t operator()(std::string_view key) const {return std::hash<std::string_view>{}(key);}
+
+	uint64_t seed() const {return 0;}
+};
+
+/** The `splitmix64` step: a bijection that spreads every bit of `x` over the result. */
+inline uint64_t splitMix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/**
+ *	Returns a new seed for a seeded hasher. The process draws one value from
+ *	`std::random_device` and every call mixes it with a counter, so seeds
+ *	are unpredictable from outside the process, differ between tables and
+ *	cost no system call after the first.
+ */
+inline uint64_t randomHashSeed() {
+	static const uint64_t base = []() {
+		std::random_device device;
+		return (static_cast<uint64_t>(device()) << 32) ^ static_cast<uint64_t>(device());
+	}();
+	static std::atomic<uint64_t> counter = 0;
+	return splitMix(base ^ splitMix(counter.fetch_add(1, std::memory_order_relaxed)));
+}
+
+/**
+ *	SipHash with `C` compression rounds per 8-byte word and `D`
+ *	finalization rounds, keyed by `k0` and `k1`. Words are read in host byte
+ *	order, which is the reference SipHash on little-endian machines.
+ */
+template<int C, int D>
+uint64_t sipHash(const void *data, size_t size, uint64_t k0, uint64_t k1) {
+	uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+	uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+	uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+	uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+	auto round = [&]() {
+		v0 += v1; v1 = std::rotl(v1, 13); v1 ^= v0; v0 = std::rotl(v0, 32);
+		v2 += v3; v3 = std::rotl(v3, 16); v3 ^= v2;
+		v0 += v3; v3 = std::rotl(v3, 21); v3 ^= v0;
+		v2 += v1; v1 = std::rotl(v1, 17); v1 ^= v2; v2 = std::rotl(v2, 32);
+	};
+	auto compress = [&](uint64_t word) {
+		v3 ^= word;
+		for (int i = 0; i < C; ++i) {round();}
+		v0 ^= word;
+	};
+
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	const size_t wholeWords = size / 8;
+	for (size_t i = 0; i < wholeWords; ++i) {
+		uint64_t word;
+		std::memcpy(&word, bytes + 8 * i, 8);
+		compress(word);
+	}
+
+	// The last word holds the remaining bytes and the length in its top byte.
+	uint64_t last = static_cast<uint64_t>(size) << 56;
+	for (size_t i = 8 * wholeWords; i < size; ++i) {last |= static_cast<uint64_t>(bytes[i]) << (8 * (i % 8));}
+	compress(last);
+
+	v2 ^= 0xff;
+	for (int i = 0; i < D; ++i) {round();}
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/**
+ *	Keyed, transparent string hasher: SipHash-1-3 under a 128-bit key
+ *	expanded from a 64-bit seed. Without the seed, colliding keys cannot be
+ *	computed ahead of time, so keys chosen by a client cannot force the
+ *	`O(n)` probe sequences of a table. A default-constructed hasher takes a
+ *	new seed from `randomHashSeed()`, so every table hashes differently.
+ *
+ *	Costs a few more nanoseconds per key than `StringHash`.
+ */
+class SipHash {
+	public:
+		using is_transparent = void;
+
+		static constexpr bool seeded = true;
+
+		SipHash() : SipHash(randomHashSeed()) {}
+		explicit SipHash(uint64_t seed) : hashSeed(seed), k0(splitMix(seed)), k1(splitMix(seed ^ 0x5851f42d4c957f2dULL)) {}
+
+		size_t operator()(std::string_view key) const {return static_cast<size_t>(sipHash<1, 3>(key.data(), key.size(), this->k0, this->k1));}
+
+		uint64_t seed() const {return this->hashSeed;}
+
+	private:
+		uint64_t hashSeed;
+		uint64_t k0;
+		uint64_t k1;
+};
+
+/**
+ *	CPU features the hashers below dispatch on, checked once per process.
+ *	Only GCC and Clang on x86 get the hardware paths; every other build
+ *	uses the portable fallbacks.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HASHTABLE_X86_DISPATCH 1
+#include <immintrin.h>
+
+inline bool cpuHasSse42() {
+	static const bool supported = []() {__builtin_cpu_init(); return __builtin_cpu_supports("sse4.2") != 0;}();
+	return supported;
+}
+
+inline bool cpuHasAes() {
+	static const bool supported = []() {__builtin_cpu_init(); return __builtin_cpu_supports("aes") != 0 && __builtin_cpu_supports("sse4.1") != 0;}();
+	return supported;
+}
+#else
+inline bool cpuHasSse42() {return false;}
+inline bool cpuHasAes() {return false;}
+#endif
+
+/** Reads a `T` from the unaligned bytes at `data`, in host byte order. */
+template<typename T>
+inline T readWord(const unsigned char *data) {
+	T word;
+	std::memcpy(&word, data, sizeof(T));
+	return word;
+}
+
+/** Stores the 128-bit product of `a` and `b` in `low` and `high`. */
+inline void multiply128(uint64_t a, uint64_t b, uint64_t &low, uint64_t &high) {
+#ifdef __SIZEOF_INT128__
+	const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	low = static_cast<uint64_t>(product);
+	high = static_cast<uint64_t>(product >> 64);
+#else
+	const uint64_t aLow = a & 0xffffffffULL, aHigh = a >> 32, bLow = b & 0xffffffffULL, bHigh = b >> 32;
+	const uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh, highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+	const uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffffULL) + (highLow & 0xffffffffULL);
+	low = (middle << 32) | (lowLow & 0xffffffffULL);
+	high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+#endif
+}
+
+/** Multiplies `a` by `b` and folds the 128-bit product into 64 bits. */
+inline uint64_t foldedMultiply(uint64_t a, uint64_t b) {
+	uint64_t low, high;
+	multiply128(a, b, low, high);
+	return low ^ high;
+}
+
+/**
+ *	Hash in the style of wyhash: 16 bytes per folded 64x64-bit multiply,
+ *	three independent lanes for keys over 48 bytes, and keys up to 16 bytes
+ *	read with at most two overlapping loads and no loop.
+ */
+inline uint64_t wyHash(const void *data, size_t size, uint64_t seed) {
+	constexpr uint64_t P0 = 0x2d358dccaa6c78a5ULL, P1 = 0x8bb84b93962eacc9ULL, P2 = 0x4b33a62ed433d4a3ULL, P3 = 0x4d5a2da51de1aa47ULL;
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	seed ^= foldedMultiply(seed ^ P0, P1);
+
+	uint64_t a, b;
+	if (size <= 16) {
+		if (size >= 4) {
+			// Two 4-byte reads from each end, overlapping for keys under 8 bytes.
+			const size_t middle = (size >> 3) << 2;
+			a = (static_cast<uint64_t>(readWord<uint32_t>(bytes)) << 32) | readWord<uint32_t>(bytes + middle);
+			b = (static_cast<uint64_t>(readWord<uint32_t>(bytes + size - 4)) << 32) | readWord<uint32_t>(bytes + size - 4 - middle);
+		} else if (size > 0) {
+			a = (static_cast<uint64_t>(bytes[0]) << 16) | (static_cast<uint64_t>(bytes[size >> 1]) << 8) | bytes[size - 1];
+			b = 0;
+		} else {
+			a = 0;
+			b = 0;
+		}
+	} else {
+		size_t remaining = size;
+		if (remaining > 48) {
+			uint64_t lane1 = seed, lane2 = seed;
+			do {
+				seed = foldedMultiply(readWord<uint64_t>(bytes) ^ P1, readWord<uint64_t>(bytes + 8) ^ seed);
+				lane1 = foldedMultiply(readWord<uint64_t>(bytes + 16) ^ P2, readWord<uint64_t>(bytes + 24) ^ lane1);
+				lane2 = foldedMultiply(readWord<uint64_t>(bytes + 32) ^ P3, readWord<uint64_t>(bytes + 40) ^ lane2);
+				bytes += 48;
+				remaining -= 48;
+			} while (remaining > 48);
+			seed ^= lane1 ^ lane2;
+		}
+		while (remaining > 16) {
+			seed = foldedMultiply(readWord<uint64_t>(bytes) ^ P1, readWord<uint64_t>(bytes + 8) ^ seed);
+			bytes += 16;
+			remaining -= 16;
+		}
+		// The last 16 bytes of the key, overlapping what was already mixed.
+		a = readWord<uint64_t>(bytes + remaining - 16);
+		b = readWord<uint64_t>(bytes + remaining - 8);
+	}
+
+	multiply128(a ^ P1, b ^ seed, a, b);
+	return foldedMultiply(a ^ P0 ^ size, b ^ P1);
+}
+
+/**
+ *	Seeded, transparent string hasher built on `wyHash`, the fastest of the
+ *	portable hashers here for keys of 8 to 64 bytes. Every default-constructed
+ *	hasher takes a new seed, like `SipHash`, which keeps colliding keys from
+ *	being precomputed; unlike SipHash it is not a keyed pseudorandom
+ *	function, so use `SipHash` where keys come from an adversary.
+ */
+class WyHash {
+	public:
+		using is_transparent = void;
+
+		static constexpr bool seeded = true;
+
+		WyHash() : WyHash(randomHashSeed()) {}
+		explicit WyHash(uint64_t seed) : hashSeed(seed) {}
+
+		size_t operator()(std::string_view key) const {return static_cast<size_t>(wyHash(key.data(), key.size(), this->hashSeed));}
+
+		uint64_t seed() const {return this->hashSeed;}
+
+	private:
+		uint64_t hashSeed;
+};
+
+/** Table of the byte-at-a-time CRC32C, the reflected Castagnoli polynomial `0x82f63b78`. */
+struct Crc32cTable {
+	uint32_t entries[256];
+
+	constexpr Crc32cTable() : entries() {
+		for (uint32_t byte = 0; byte < 256; ++byte) {
+			uint32_t crc = byte;
+			for (int bit = 0; bit < 8; ++bit) {crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78U : 0);}
+			this->entries[byte] = crc;
+		}
+	}
+};
+
+/** CRC32C of `size` bytes one byte at a time, for CPUs without SSE4.2. */
+inline uint32_t crc32cPortable(const void *data, size_t size, uint32_t crc) {
+	static constexpr Crc32cTable TABLE;
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i) {crc = TABLE.entries[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);}
+	return ~crc;
+}
+
+#ifdef HASHTABLE_X86_DISPATCH
+/** CRC32C of `size` bytes with the SSE4.2 `crc32` instruction, 8 bytes at a time. */
+__attribute__((target("sse4.2")))
+inline uint32_t crc32cSse42(const void *data, size_t size, uint32_t crc) {
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	uint64_t state = ~crc;
+	size_t i = 0;
+#if defined(__x86_64__)
+	for (; i + 8 <= size; i += 8) {state = _mm_crc32_u64(state, readWord<uint64_t>(bytes + i));}
+#endif
+	uint32_t narrow = static_cast<uint32_t>(state);
+	for (; i < size; ++i) {narrow = _mm_crc32_u8(narrow, bytes[i]);}
+	return ~narrow;
+}
+#endif
+
+/** CRC32C of `size` bytes, with SSE4.2 if the CPU has it. Both paths return the same value. */
+inline uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0) {
+#ifdef HASHTABLE_X86_DISPATCH
+	if (cpuHasSse42()) {return crc32cSse42(data, size, crc);}
+#endif
+	return crc32cPortable(data, size, crc);
+}
+
+/**
+ *	Transparent string hasher using the CRC32C instruction of SSE4.2, with a
+ *	table-driven fallback on other CPUs. The checksum has 32 bits, widened
+ *	to 64 by an odd multiplier, so about one pair of keys in `2^32` shares
+ *	a hash code. A CRC is linear: its collisions do not depend on a seed,
+ *	so this hasher is unseeded and must not hash untrusted keys.
+ */
+struct Crc32cHash {
+	using is_transparent = void;
+
+	static constexpr bool seeded = false;
+
+	Crc32cHash() = default;
+	explicit Crc32cHash(uint64_t) {}
+
+	size_t operator()(std::string_view key) const {
+		return static_cast<size_t>(static_cast<uint64_t>(crc32c(key.data(), key.size())) * 0x9e3779b97f4a7c15ULL);
+	}
+
+	uint64_t seed() const {return 0;}
+};
+
+#if defined(HASHTABLE_X86_DISPATCH) && defined(__x86_64__)
+/**
+ *	AES-NI hash: the state starts as one AES round of the length, then each
+ *	16-byte block is XORed into the state and mixed by one AES round under a
+ *	seeded round key; three more rounds finish the state, whose two halves
+ *	are folded together. The length is in the state, so the last block may
+ *	overlap the one before it instead of being padded through memory.
+ */
+__attribute__((target("aes,sse4.1")))
+inline uint64_t aesHashAesNi(const void *data, size_t size, uint64_t seed) {
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	const __m128i roundKey = _mm_set_epi64x(static_cast<long long>(splitMix(seed)), static_cast<long long>(seed));
+	// The length goes through a round of its own, so it cannot cancel a difference in the first block.
+	__m128i state = _mm_aesenc_si128(_mm_xor_si128(roundKey, _mm_set_epi64x(0, static_cast<long long>(size))), roundKey);
+
+	for (size_t i = 0; i + 16 < size; i += 16) {
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+		state = _mm_aesenc_si128(_mm_xor_si128(state, block), roundKey);
+	}
+
+	// The last block is the last 16 bytes, overlapping the previous block, or two overlapping reads of a shorter key.
+	__m128i last;
+	if (size >= 16) {last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + size - 16));}
+	else if (size >= 8) {last = _mm_set_epi64x(static_cast<long long>(readWord<uint64_t>(bytes + size - 8)), static_cast<long long>(readWord<uint64_t>(bytes)));}
+	else if (size >= 4) {last = _mm_set_epi64x(readWord<uint32_t>(bytes + size - 4), readWord<uint32_t>(bytes));}
+	else if (size > 0) {last = _mm_set_epi64x(0, (bytes[0] << 16) | (bytes[size >> 1] << 8) | bytes[size - 1]);}
+	else {last = _mm_setzero_si128();}
+	state = _mm_aesenc_si128(_mm_xor_si128(state, last), roundKey);
+
+	state = _mm_aesenc_si128(state, roundKey);
+	state = _mm_aesenc_si128(state, _mm_shuffle_epi32(roundKey, 0x4e));
+	state = _mm_aesenclast_si128(state, roundKey);
+	return static_cast<uint64_t>(_mm_extract_epi64(state, 0)) ^ static_cast<uint64_t>(_mm_extract_epi64(state, 1));
+}
+#endif
+
+/**
+ *	Seeded, transparent string hasher that mixes 16 bytes per AES round with
+ *	AES-NI, chosen at run time. CPUs without AES-NI, and builds other than
+ *	GCC or Clang on x86, fall back to `wyHash` with the same seed, so the hash
+ *	codes differ between the two paths: an image saved on one opens only on
+ *	a machine taking the same path. Like `WyHash`, it resists precomputed
+ *	collisions but is no substitute for `SipHash` against an adversary.
+ */
+class AesHash {
+	public:
+		using is_transparent = void;
+
+		static constexpr bool seeded = true;
+
+		AesHash() : AesHash(randomHashSeed()) {}
+		explicit AesHash(uint64_t seed) : hashSeed(seed) {}
+
+		size_t operator()(std::string_view key) const {
+#if defined(HASHTABLE_X86_DISPATCH) && defined(__x86_64__)
+			if (cpuHasAes()) {return static_cast<size_t>(aesHashAesNi(key.data(), key.size(), this->hashSeed));}
+#endif
+			return static_cast<size_t>(wyHash(key.data(), key.size(), this->hashSeed));
+		}
+
+		uint64_t seed() const {return this->hashSeed;}
+
+	private:
+		uint64_t hashSeed;
+};
+
+/** Default hasher and key equality: transparent for `std::string` keys. */
+template<typename Key> struct DefaultHash {using type = std::hash<Key>;};
+template<> struct DefaultHash<std::string> {using type = StringHash;};
+
+template<typename Key> struct DefaultEqual {using type = std::equal_to<Key>;};
+template<> struct DefaultEqual<std::string> {using type = std::equal_to<>;};
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ *	HashTableHashBench.cpp
+ *
+ *	Compares the string hashers of `HashTableHash.h` in three parts:
+ *
+ *	-	Speed: nanoseconds per hash by key length.
+ *	-	Quality: probe lengths of a `FlatHashtable_t` with linear probing at
+ *		load factor 0.75, summarized like `HashTable::stats()`, for random
+ *		and for sequential keys, and how many keys share a full 64-bit hash
+ *		code. Linear probing at that load expects a mean of 2.5 probes per
+ *		hit with a uniform hash; a weak hash shows up as a longer mean or
+ *		tail.
+ *	-	Hash flooding: inserting and looking up keys chosen to collide under
+ *		the unseeded `StringHash`, against random keys, in `Hashtable_t`
+ *		with `StringHash` and with the seeded `SipHash`, and in `HashTable`
+ *		with the key hash it was built with (`HASHTABLE_HASH`).
+ *
+ *	The colliding keys are found the way an attacker would: by hashing
+ *	candidate keys offline until enough of them have the same home bucket
+ *	under `PowerOfTwoIndexing` at the capacity the table will reach. The
+ *	home bucket is the same at every smaller capacity too, so every insert
+ *	and every lookup walks one cluster of all the keys inserted so far. A
+ *	seeded hash scatters the same keys like random ones.
+ *
+ *	Usage: `HashTableHashBench [keys]`, the number of colliding keys,
+ *	default 4000. Finding them takes about `2 * keys^2` hashes.
+ */
+
+#include "HashTable.h"
+#include "HashTableBenchUtil.h"
+#include "HashTableFlat.h"
+#include "HashTableImpl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/** Returns nanoseconds per hash of `keys`, hashed over and over for at least 50 ms. */
+template<typename Hash>
+double hashSpeed(const std::vector<std::string> &keys) {
+	const Hash hash(1);
+	size_t rounds = 0, sum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	do {
+		for (const std::string &key : keys) {sum += hash(key);}
+		++rounds;
+	} while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50));
+	const double nanos = nanosPerKey(start, rounds * keys.size());
+
+	// Keeps the hashing loop from being optimized away.
+	if (sum == 42) {std::puts("");}
+	return nanos;
+}
+
+/**
+ *	Inserts `keys` into a linear-probing `FlatHashtable_t` of `capacity`
+ *	buckets and prints the probe lengths of hits and the keys whose full
+ *	hash code another key already has.
+ */
+template<typename Hash>
+void hashQuality(const char *name, const char *keySet, size_t capacity, const std::vector<std::string> &keys) {
+	FlatHashtable_t<std::string, size_t, Hash, std::equal_to<>, LinearProbing> table(capacity, Hash(1));
+	table.max_load_factor(0.9);
+	for (size_t i = 0; i < keys.size(); ++i) {table.insert(keys[i], i);}
+
+	LengthStats probes;
+	for (const std::string &key : keys) {probes.add(table.probeLength(key));}
+	probes.summarize();
+
+	std::vector<uint64_t> hashes(keys.size());
+	for (size_t i = 0; i < keys.size(); ++i) {hashes[i] = Hash(1)(keys[i]);}
+	std::sort(hashes.begin(), hashes.end());
+	const size_t collisions = static_cast<size_t>(hashes.end() - std::unique(hashes.begin(), hashes.end()));
+
+	std::printf("%-12s %-12s %10.3f %6zu %6zu %12zu\n", name, keySet, probes.mean, probes.p99, probes.max, collisions);
+}
+
+/** Times inserting every key into an empty `Table` and then looking each one up. */
+template<typename Table>
+void measure(const char *name, const char *keySet, const std::vector<std::string> &keys) {
+	Table table;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < keys.size(); ++i) {table.insert(keys[i], i);}
+	const double nanosPerInsert = nanosPerKey(start, keys.size());
+
+	size_t found = 0;
+	start = std::chrono::steady_clock::now();
+	for (const std::string &key : keys) {found += table.contains(key);}
+	const double nanosPerLookup = nanosPerKey(start, keys.size());
+
+	std::printf("%-26s %-12s %12.1f %12.1f %10zu\n", name, keySet, nanosPerInsert, nanosPerLookup, table.capacity());
+	if (found != keys.size()) {std::printf("lost keys\n");}
+}
+
+int main(int argc, char **argv) {
+	const size_t keyCount = (argc > 1) ? static_cast<size_t>(std::atoll(argv[1])) : 4000;
+	std::mt19937_64 random(42);
+
+	std::printf("ns/hash by key length, %s\n\n", cpuHasAes() ? "AES-NI and SSE4.2 in use" : cpuHasSse42() ? "SSE4.2 in use, no AES-NI" : "portable paths");
+	std::printf("%8s %12s %12s %12s %12s %12s\n", "length", "StringHash", "SipHash", "WyHash", "AesHash", "Crc32cHash");
+	for (const size_t length : {4, 8, 12, 16, 24, 32, 48, 64, 128, 256}) {
+		std::vector<std::string> keys(4096);
+		for (std::string &key : keys) {key = randomString(random, length);}
+		std::printf("%8zu %12.2f %12.2f %12.2f %12.2f %12.2f\n", length, hashSpeed<StringHash>(keys), hashSpeed<SipHash>(keys),
+			hashSpeed<WyHash>(keys), hashSpeed<AesHash>(keys), hashSpeed<Crc32cHash>(keys));
+	}
+
+	const size_t capacity = size_t{1} << 20;
+	std::vector<std::string> randomKeys(capacity / 4 * 3), sequentialKeys(capacity / 4 * 3);
+	for (std::string &key : randomKeys) {key = "key:" + std::to_string(random());}
+	for (size_t i = 0; i < sequentialKeys.size(); ++i) {sequentialKeys[i] = "key:" + std::to_string(i);}
+
+	std::printf("\nprobes per hit, linear probing, %zu keys in %zu buckets\n\n", randomKeys.size(), capacity);
+	std::printf("%-12s %-12s %10s %6s %6s %12s\n", "hash", "keys", "mean", "p99", "max", "collisions");
+	hashQuality<StringHash>("StringHash", "random", capacity, randomKeys);
+	hashQuality<StringHash>("StringHash", "sequential", capacity, sequentialKeys);
+	hashQuality<SipHash>("SipHash", "random", capacity, randomKeys);
+	hashQuality<SipHash>("SipHash", "sequential", capacity, sequentialKeys);
+	hashQuality<WyHash>("WyHash", "random", capacity, randomKeys);
+	hashQuality<WyHash>("WyHash", "sequential", capacity, sequentialKeys);
+	hashQuality<AesHash>("AesHash", "random", capacity, randomKeys);
+	hashQuality<AesHash>("AesHash", "sequential", capacity, sequentialKeys);
+	hashQuality<Crc32cHash>("Crc32cHash", "random", capacity, randomKeys);
+	hashQuality<Crc32cHash>("Crc32cHash", "sequential", capacity, sequentialKeys);
+
+	const size_t mask = PowerOfTwoIndexing::roundCapacity(GrowthPolicy().bucketsFor(keyCount)) - 1;
+	randomKeys.resize(keyCount);
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::string> collidingKeys;
+	size_t candidates = 0;
+	while (collidingKeys.size() < keyCount) {
+		std::string key = "key:" + std::to_string(candidates++);
+		if ((mixHash(StringHash()(key)) & mask) == 0) {collidingKeys.push_back(std::move(key));}
+	}
+	const double searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("\nhash flooding, %zu keys, %zu buckets, colliding keys found in %zu candidates, %.2f s\n\n", keyCount, mask + 1, candidates, searchSeconds);
+	std::printf("%-26s %-12s %12s %12s %10s\n", "table", "keys", "ns/insert", "ns/lookup", "capacity");
+
+	measure<Hashtable_t<std::string, size_t, StringHash>>("Hashtable_t StringHash", "random", randomKeys);
+	measure<Hashtable_t<std::string, size_t, StringHash>>("Hashtable_t StringHash", "colliding", collidingKeys);
+	measure<Hashtable_t<std::string, size_t, SipHash>>("Hashtable_t SipHash", "random", randomKeys);
+	measure<Hashtable_t<std::string, size_t, SipHash>>("Hashtable_t SipHash", "colliding", collidingKeys);
+
+	const std::string hashTableName = std::string("HashTable ") + (HashTable::Hash::seeded ? "seeded" : "unseeded");
+	measure<HashTable>(hashTableName.c_str(), "random", randomKeys);
+	measure<HashTable>(hashTableName.c_str(), "colliding", collidingKeys);
+
+	return 0;
+}
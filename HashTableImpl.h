@@ -0,0 +1,428 @@
+/**
+ *	HashTableImpl.h
+ *
+ *	Header-only, fully templated hash table with a pluggable hasher and
+ *	key equality. It keeps the semantics of `HashTable`, but the key and
+ *	value types are template parameters instead of `std::string`/`size_t`.
+ */
+
+#ifndef HASHTABLEIMPL_H
+#define HASHTABLEIMPL_H
+
+#include <algorithm>
+#include <vector>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include "HashTableBucketImpl.h"
+#include "HashTableHash.h"
+#include "HashTableProbing.h"
+#include "HashTableGrowth.h"
+
+template<typename, typename, typename, typename, typename, typename>
+class IncrementalHashtable_t;
+
+template<
+	typename Key,
+	typename Value,
+	typename Hash = typename DefaultHash<Key>::type,
+	typename Eq = typename DefaultEqual<Key>::type,
+	typename Probing = LinearProbing,
+	typename Indexing = PowerOfTwoIndexing
+>
+class Hashtable_t {
+	public:
+		using key_type = Key;
+		using mapped_type = Value;
+		using hasher = Hash;
+		using key_equal = Eq;
+		using probing_type = Probing;
+		using indexing_type = Indexing;
+
+		static_assert(!Probing::requiresPowerOfTwo || Indexing::powerOfTwo, "probing strategy needs a power-of-two capacity");
+		using Bucket = HashTableBucket_t<Key, Value>;
+
+		/**
+		 *	`true` if both the hasher and the key equality declare `is_transparent`,
+		 *	in which case lookups accept any type they can hash and compare, e.g.
+		 *	`std::string_view` or `const char *` for `std::string` keys.
+		 */
+		static constexpr bool isTransparent = requires {
+			typename Hash::is_transparent;
+			typename Eq::is_transparent;
+		};
+
+		/** Default capacity for the hash table, matching `HashTable`. */
+		static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
+
+		/**
+		 *	The internal capacity of the hash table is set to the initial
+		 *	capacity, if specified. Default is 8.
+		 */
+		explicit Hashtable_t(size_t initCapacity = DEFAULT_INITIAL_CAPACITY, const Hash &hash = Hash(), const Eq &equal = Eq())
+			: length(0), tombstones(0), hash(hash), equal(equal) {
+			initCapacity = Indexing::roundCapacity(initCapacity);
+			this->indexing.reset(initCapacity);
+			this->probing.reset(initCapacity);
+			this->tableData.resize(initCapacity);
+		}
+
+		/**
+		 *	@brief Inserts a new key-value pair into the table.
+		 *
+		 *	Returns `true` if a unique key is inserted, `false` if the key was
+		 *	already present, in which case its value is overwritten.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		bool insert(const Key &key, const Value &value) {return this->emplace(key, value);}
+		bool insert(Key &&key, Value &&value) {return this->emplace(std::move(key), std::move(value));}
+
+		/**
+		 *	@brief Returns `true` if and only if a specified key exists in the table,
+		 *		in addition, removes that key in the table.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		bool remove(const Key &key) {return this->erase(key);}
+
+		template<typename K> requires isTransparent
+		bool remove(const K &key) {return this->erase(key);}
+
+		/**
+		 *	@brief Returns `true` if and only if a specified key exists in the table.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		bool contains(const Key &key) const {return this->find(key) != npos;}
+
+		template<typename K> requires isTransparent
+		bool contains(const K &key) const {return this->find(key) != npos;}
+
+		/**
+		 *	If the key is found in the table, return the value that is associated
+		 *	with that key. Otherwise, returns `nullopt`.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		std::optional<Value> get(const Key &key) const {return this->lookup(key);}
+
+		template<typename K> requires isTransparent
+		std::optional<Value> get(const K &key) const {return this->lookup(key);}
+
+		/**
+		 *	Returns a reference to the value associated with the specified key.
+		 *	If a key is not found in the table, it is inserted with a
+		 *	value-initialized value first, like `HashTable::operator[]`.
+		 *
+		 *	The time complexity is bounded to `O(1) <= T <= O(n)`.
+		 */
+		Value & operator[](const Key &key) {return this->tableData[this->findOrInsert(key).first].valueOf();}
+		Value & operator[](Key &&key) {return this->tableData[this->findOrInsert(std::move(key)).first].valueOf();}
+
+		/**
+		 *	@brief Calls `update(value)` on the value of `key`, inserting the key
+		 *		with a value-initialized value first if it is missing, with a
+		 *		single probe sequence.
+		 *
+		 *	Returns `true` if the key was inserted.
+		 */
+		template<typename Fn>
+		bool upsert(const Key &key, Fn &&update) {
+			const auto [bucketIndex, inserted] = this->findOrInsert(key);
+			update(this->tableData[bucketIndex].valueOf());
+			return inserted;
+		}
+
+		/**
+		 *	@brief Adds `delta` to the value of `key`, inserting the key with a
+		 *		value-initialized value first if it is missing, and returns the
+		 *		value before the addition.
+		 */
+		Value fetch_add(const Key &key, const Value &delta) requires requires(Value a, const Value b) {a += b;} {
+			Value &value = this->tableData[this->findOrInsert(key).first].valueOf();
+			const Value previous = value;
+			value += delta;
+			return previous;
+		}
+
+		/** Returns a vector of keys that are currently in the table. */
+		std::vector<Key> keys() const {
+			std::vector<Key> keyList;
+			keyList.reserve(this->size());
+
+			for (const Bucket &bucket : this->tableData) {
+				if (!bucket.isEmpty()) {keyList.push_back(bucket.getKey());}
+			}
+
+			return keyList;
+		}
+
+		/** Returns the load factor of the table, which is `size / capacity`. */
+		double alpha() const {
+			return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
+		}
+
+		/** Returns the load factor at which the table grows. Default is 0.5. */
+		double max_load_factor() const {return this->growth.maxLoadFactor;}
+
+		/**
+		 *	Sets the load factor at which the table grows, which must lie in `(0, 1)`.
+		 *	If the table is already past it, the table is rehashed right away.
+		 */
+		void max_load_factor(double maxLoadFactor) {
+			this->growth.setMaxLoadFactor(maxLoadFactor);
+			if (this->growth.exceeds(this->size(), this->capacity())) {this->rehash(0);}
+		}
+
+		/** Returns the factor the capacity is multiplied by on growth. Default is 2. */
+		double growth_factor() const {return this->growth.growthFactor;}
+
+		/** Sets the factor the capacity is multiplied by on growth, which must be greater than 1. */
+		void growth_factor(double growthFactor) {this->growth.setGrowthFactor(growthFactor);}
+
+		/**
+		 *	Makes room for `count` entries, so inserting up to `count` keys does a
+		 *	single allocation here and no resize afterwards.
+		 */
+		void reserve(size_t count) {
+			if (this->growth.bucketsFor(count) > this->capacity()) {this->resize(this->growth.bucketsFor(count));}
+		}
+
+		/**
+		 *	Rebuilds the table with at least `count` buckets, and at least enough to
+		 *	keep the current entries below the max load factor.
+		 */
+		void rehash(size_t count) {
+			this->resize(std::max(count, this->growth.bucketsFor(this->size())));
+		}
+
+		/** Returns the number of buckets in the hash table. */
+		size_t capacity() const {return this->tableData.size();}
+
+		/** Returns the number of existing key-value pairs in the hash table. */
+		size_t size() const {return this->length;}
+
+		/** Returns the number of `EAR` buckets, which still lengthen probe sequences. */
+		size_t tombstoneCount() const {return this->tombstones;}
+
+		/**
+		 *	Prints all normal buckets of the table as
+		 *	`[0: <key0, value0>, 1: <key1, value1>, ...]`.
+		 */
+		friend std::ostream & operator<<(std::ostream &os, const Hashtable_t &hashTable) {
+			size_t printedBuckets = 0;
+			os << "[";
+			for (size_t bucketIndex = 0; bucketIndex < hashTable.capacity(); ++bucketIndex) {
+				const Bucket &bucket = hashTable.tableData[bucketIndex];
+				if (!bucket.isEmpty()) {
+					if (printedBuckets > 0) {os << ", ";}
+					os << bucketIndex << ": " << bucket;
+					++printedBuckets;
+				}
+			}
+			os << "]";
+			return os;
+		}
+
+	private:
+		template<typename, typename, typename, typename, typename, typename>
+		friend class IncrementalHashtable_t;
+
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		Indexing indexing;
+		Probing probing;
+		GrowthPolicy growth;
+		std::vector<Bucket> tableData;
+		size_t length;
+		size_t tombstones;
+
+		[[no_unique_address]] Hash hash;
+		[[no_unique_address]] Eq equal;
+
+		/** Returns the probe sequence of a hash code, positioned at probe `0`. */
+		ProbeCursor begin(size_t keyHash) const {return this->probing.begin(keyHash, this->indexing);}
+
+		/**
+		 *	Returns `true` if the bucket is normal and holds `key`. The keys
+		 *	are only compared if the stored hash code equals `keyHash`.
+		 */
+		template<typename K>
+		bool holds(const Bucket &bucket, const K &key, size_t keyHash) const {
+			return !bucket.isEmpty() && bucket.getHash() == keyHash && this->equal(bucket.getKey(), key);
+		}
+
+		/**
+		 *	Returns the index of the normal bucket holding `key`, or `npos`.
+		 *	The probes continue on `EAR` buckets and stop at an `ESS` bucket.
+		 */
+		template<typename K>
+		size_t find(const K &key) const {return this->find(key, this->hash(key));}
+
+		/** Like `find(key)`, with the hash code of `key` already computed. */
+		template<typename K>
+		size_t find(const K &key, size_t keyHash) const {
+			ProbeCursor probe = this->begin(keyHash);
+			while (true) {
+				const Bucket &bucket = this->tableData[probe.index];
+				if (bucket.isEmptySinceStart()) {return npos;}
+				if (this->holds(bucket, key, keyHash)) {return probe.index;}
+				this->probing.advance(probe, this->indexing);
+			}
+		}
+
+		/** Shared body of both `get` overloads. */
+		template<typename K>
+		std::optional<Value> lookup(const K &key) const {
+			const size_t bucketIndex = this->find(key);
+			if (bucketIndex == npos) {return std::nullopt;}
+			return std::optional<Value>(this->tableData[bucketIndex].valueOf());
+		}
+
+		/**
+		 *	Shared body of both `remove` overloads. Found buckets become `EAR`,
+		 *	unless the probing strategy asks for backward-shift deletion.
+		 */
+		template<typename K>
+		bool erase(const K &key) {
+			const size_t bucketIndex = this->find(key);
+			if (bucketIndex == npos) {return false;}
+			if constexpr (usesBackwardShift<Probing>) {
+				this->shiftBack(bucketIndex);
+			} else {
+				this->tableData[bucketIndex].makeEAR();
+				++this->tombstones;
+			}
+			--this->length;
+			return true;
+		}
+
+		/**
+		 *	Moves later entries of the cluster after `hole` back into the gap,
+		 *	skipping those whose home bucket lies between the gap and themselves.
+		 *	The last gap becomes `ESS`.
+		 */
+		void shiftBack(size_t hole) {
+			size_t bucketIndex = hole;
+			while (true) {
+				bucketIndex = this->indexing.wrap(bucketIndex + 1);
+				Bucket &bucket = this->tableData[bucketIndex];
+				if (bucket.isEmptySinceStart()) {break;}
+				if (cyclicallyBetween(hole, this->indexing.home(bucket.getHash()), bucketIndex)) {continue;}
+				this->tableData[hole] = std::move(bucket);
+				hole = bucketIndex;
+			}
+			this->tableData[hole].makeESS();
+		}
+
+		/** Shared body of both `insert` overloads. */
+		template<typename K, typename V>
+		bool emplace(K &&key, V &&value) {
+			const auto [bucketIndex, inserted] = this->findOrInsert(std::forward<K>(key));
+			this->tableData[bucketIndex].valueOf() = std::forward<V>(value);
+			return inserted;
+		}
+
+		/**
+		 *	Outcome of probing for a key: the normal bucket holding it, or
+		 *	`npos`, and the first `EAR` or `ESS` bucket along its probe sequence.
+		 */
+		struct Slot {
+			size_t index;
+			size_t firstFree;
+		};
+
+		/**
+		 *	Shared probe of `insert`, `upsert`, `fetch_add` and `operator[]`.
+		 *	Returns the index of the bucket holding `key`, and `true` if the key
+		 *	was absent and has just been inserted with a value-initialized value.
+		 */
+		template<typename K>
+		std::pair<size_t, bool> findOrInsert(K &&key) {
+			const size_t keyHash = this->hash(key);
+			const Slot slot = this->locate(key, keyHash);
+			if (slot.index != npos) {return {slot.index, false};}
+			return {this->insertAt(slot.firstFree, std::forward<K>(key), keyHash), true};
+		}
+
+		/**
+		 *	Probes for `key`, whose hash code is `keyHash`, until it is found or
+		 *	an `ESS` bucket is reached, and remembers the first `EAR` bucket on
+		 *	the way, so a new key can reuse it.
+		 */
+		template<typename K>
+		Slot locate(const K &key, size_t keyHash) const {
+			ProbeCursor probe = this->begin(keyHash);
+			size_t firstFree = npos;
+			while (true) {
+				const Bucket &bucket = this->tableData[probe.index];
+				if (bucket.isEmptySinceStart()) {
+					if (firstFree == npos) {firstFree = probe.index;}
+					return Slot{npos, firstFree};
+				} else if (bucket.isEmptyAfterRemove()) {
+					if (firstFree == npos) {firstFree = probe.index;}
+				} else if (bucket.getHash() == keyHash && this->equal(bucket.getKey(), key)) {
+					return Slot{probe.index, npos};
+				}
+				this->probing.advance(probe, this->indexing);
+			}
+		}
+
+		/**
+		 *	Inserts `key`, which `locate` found absent, with a value-initialized
+		 *	value into `firstFree`, and returns its bucket index. If the new key
+		 *	would reach the max load factor, the table is rebuilt before the key
+		 *	is placed, so the returned index stays valid.
+		 */
+		template<typename K>
+		size_t insertAt(size_t firstFree, K &&key, size_t keyHash) {
+			const size_t tombstonesAfter = this->tombstones - (this->tableData[firstFree].isEmptyAfterRemove() ? 1 : 0);
+			const size_t newCapacity = this->growth.rebuildCapacity(this->size() + 1, tombstonesAfter, this->capacity());
+			if (newCapacity > 0) {
+				this->resize(newCapacity);
+				ProbeCursor probe = this->begin(keyHash);
+				while (!this->tableData[probe.index].isEmptySinceStart()) {this->probing.advance(probe, this->indexing);}
+				firstFree = probe.index;
+			}
+
+			Bucket &freeBucket = this->tableData[firstFree];
+			if (freeBucket.isEmptyAfterRemove()) {--this->tombstones;}
+			freeBucket.load(std::forward<K>(key), Value{}, keyHash);
+			++this->length;
+			return firstFree;
+		}
+
+		/**
+		 *	Changes the capacity to at least `newCapacity` and moves every normal
+		 *	bucket into its bucket index in the new table, dropping every `EAR` bucket.
+		 */
+		void resize(size_t newCapacity) {
+			const size_t newSize = Indexing::roundCapacity(newCapacity);
+			std::vector<Bucket> oldTableData(newSize);
+			oldTableData.swap(this->tableData);
+			this->tombstones = 0;
+			this->indexing.reset(newSize);
+			this->probing.reset(newSize);
+
+			for (Bucket &bucket : oldTableData) {
+				if (!bucket.isEmpty()) {this->place(std::move(bucket));}
+			}
+		}
+
+		/**
+		 *	Moves a normal bucket whose key is absent from the table into the
+		 *	first `ESS` or `EAR` bucket along its probe sequence, without
+		 *	comparing or hashing keys. `size` is left to the caller.
+		 */
+		void place(Bucket &&bucket) {
+			ProbeCursor probe = this->begin(bucket.getHash());
+			while (!this->tableData[probe.index].isEmpty()) {
+				this->probing.advance(probe, this->indexing);
+			}
+			if (this->tableData[probe.index].isEmptyAfterRemove()) {--this->tombstones;}
+			this->tableData[probe.index] = std::move(bucket);
+		}
+};
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ *	HashTableIncremental.h
+ *
+ *	`Hashtable_t` with incremental resizing, in the style of the Redis dict.
+ *	Instead of rehashing every entry inside the one `insert` that crosses the
+ *	max load factor, the full table becomes the previous table and a larger
+ *	current table takes the new entries. Every later `insert`, `remove`,
+ *	`contains`, `get` and `operator[]` moves at most `migrationStep()`
+ *	buckets of the previous table into the current one, and lookups consult
+ *	both tables until the previous one is drained and freed.
+ */
+
+#ifndef HASHTABLEINCREMENTAL_H
+#define HASHTABLEINCREMENTAL_H
+
+#include <algorithm>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "HashTableImpl.h"
+
+template<
+	typename Key,
+	typename Value,
+	typename Hash = typename DefaultHash<Key>::type,
+	typename Eq = typename DefaultEqual<Key>::type,
+	typename Probing = LinearProbing,
+	typename Indexing = PowerOfTwoIndexing
+>
+class IncrementalHashtable_t {
+	public:
+		using Table = Hashtable_t<Key, Value, Hash, Eq, Probing, Indexing>;
+		using Bucket = typename Table::Bucket;
+
+		using key_type = Key;
+		using mapped_type = Value;
+		using hasher = Hash;
+		using key_equal = Eq;
+
+		/** Fewest buckets of the previous table moved per operation. */
+		static constexpr size_t MIN_MIGRATION_STEP = 16;
+
+		explicit IncrementalHashtable_t(size_t initCapacity = Table::DEFAULT_INITIAL_CAPACITY, const Hash &hash = Hash(), const Eq &equal = Eq())
+			: current(initCapacity, hash, equal) {}
+
+		/**
+		 *	@brief Inserts a new key-value pair into the table.
+		 *
+		 *	Returns `true` if a unique key is inserted, `false` if the key was
+		 *	already present, in which case its value is overwritten. A key found
+		 *	in the previous table moves into the current one.
+		 */
+		bool insert(const Key &key, const Value &value) {return this->emplace(key, value);}
+		bool insert(Key &&key, Value &&value) {return this->emplace(std::move(key), std::move(value));}
+
+		/**
+		 *	@brief Returns `true` if and only if a specified key exists in the table,
+		 *		in addition, removes that key in the table.
+		 */
+		bool remove(const Key &key) {
+			this->migrate();
+			return this->takeFromPrevious(key) || this->current.remove(key);
+		}
+
+		/** @brief Returns `true` if and only if a specified key exists in the table. */
+		bool contains(const Key &key) {
+			this->migrate();
+			return this->current.contains(key) || (this->previous && this->previous->contains(key));
+		}
+
+		/**
+		 *	If the key is found in the table, return the value that is associated
+		 *	with that key. Otherwise, returns `nullopt`.
+		 */
+		std::optional<Value> get(const Key &key) {
+			this->migrate();
+			std::optional<Value> value = this->current.get(key);
+			if (!value && this->previous) {value = this->previous->get(key);}
+			return value;
+		}
+
+		/**
+		 *	Returns a reference to the value associated with the specified key.
+		 *	If a key is not found in either table, it is inserted into the
+		 *	current table with a value-initialized value first, like
+		 *	`Hashtable_t::operator[]`.
+		 */
+		Value & operator[](const Key &key) {
+			this->migrate();
+			const size_t keyHash = this->current.hash(key);
+			if (this->previous) {
+				const size_t bucketIndex = this->previous->find(key, keyHash);
+				if (bucketIndex != Table::npos) {return this->previous->tableData[bucketIndex].valueOf();}
+			}
+
+			const auto [bucketIndex, firstFree] = this->current.locate(key, keyHash);
+			if (bucketIndex != Table::npos) {return this->current.tableData[bucketIndex].valueOf();}
+
+			// A migration started here leaves the current table empty, so the key's home bucket is free.
+			const size_t freeIndex = this->startMigrationFor(1) ? this->current.begin(keyHash).index : firstFree;
+			return this->current.tableData[this->current.insertAt(freeIndex, key, keyHash)].valueOf();
+		}
+
+		/** Returns a vector of keys that are currently in either table. */
+		std::vector<Key> keys() const {
+			std::vector<Key> keyList = this->current.keys();
+			if (this->previous) {
+				for (Key &key : this->previous->keys()) {keyList.push_back(std::move(key));}
+			}
+			return keyList;
+		}
+
+		/** Returns the load factor of the table, which is `size / capacity`. */
+		double alpha() const {
+			return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
+		}
+
+		/** Returns the number of buckets in the current table. */
+		size_t capacity() const {return this->current.capacity();}
+
+		/** Returns the number of existing key-value pairs in both tables. */
+		size_t size() const {return this->current.size() + (this->previous ? this->previous->size() : 0);}
+
+		/** Returns `true` while buckets of a previous table are still being moved. */
+		bool migrating() const {return this->previous.has_value();}
+
+		/**
+		 *	Returns the most buckets of the previous table any single operation
+		 *	moves, or `0` if no migration is in progress. It is fixed when the
+		 *	migration starts, so it bounds the extra work of every operation.
+		 */
+		size_t migrationStep() const {return this->previous ? this->step : 0;}
+
+		/**
+		 *	Prints the normal buckets of the current table, then those of the
+		 *	previous table, as `[0: <key0, value0>, 1: <key1, value1>, ...]`.
+		 */
+		friend std::ostream & operator<<(std::ostream &os, const IncrementalHashtable_t &hashTable) {
+			os << hashTable.current;
+			if (hashTable.previous) {os << " + " << *hashTable.previous;}
+			return os;
+		}
+
+	private:
+		Table current;
+		std::optional<Table> previous;
+
+		/** Next bucket of the previous table to move. */
+		size_t cursor = 0;
+
+		/** Buckets of the previous table moved per operation. */
+		size_t step = 0;
+
+		/** Shared body of both `insert` overloads. */
+		template<typename K, typename V>
+		bool emplace(K &&key, V &&value) {
+			this->migrate();
+			this->startMigrationFor(1);
+			const bool moved = this->takeFromPrevious(key);
+			return this->current.emplace(std::forward<K>(key), std::forward<V>(value)) && !moved;
+		}
+
+		/**
+		 *	Removes `key` from the previous table, if it is there. The bucket
+		 *	becomes `EAR` even under backward-shift deletion, since shifting
+		 *	could move unvisited buckets behind the migration cursor.
+		 */
+		bool takeFromPrevious(const Key &key) {
+			if (!this->previous) {return false;}
+			const size_t bucketIndex = this->previous->find(key);
+			if (bucketIndex == Table::npos) {return false;}
+			this->previous->tableData[bucketIndex].makeEAR();
+			--this->previous->length;
+			return true;
+		}
+
+		/**
+		 *	Starts a migration instead of letting `added` more entries rebuild the
+		 *	current table in one go, and returns `true` if it did. Does nothing
+		 *	while a migration is running.
+		 */
+		bool startMigrationFor(size_t added) {
+			if (this->previous) {return false;}
+			const size_t newCapacity = this->current.growth.rebuildCapacity(this->current.size() + added, this->current.tombstones, this->current.capacity());
+			if (newCapacity == 0) {return false;}
+			this->startMigration(newCapacity);
+			return true;
+		}
+
+		/**
+		 *	The current table becomes the previous table, and an empty table with
+		 *	`newCapacity` buckets becomes the current one.
+		 *
+		 *	The step is chosen so the previous table is drained before the current
+		 *	one reaches its max load factor: each operation adds at most one entry
+		 *	or tombstone, so `headroom` operations remain after the previous
+		 *	entries are moved, and every bucket must be visited within them.
+		 */
+		void startMigration(size_t newCapacity) {
+			Table fresh(newCapacity, this->current.hash, this->current.equal);
+			fresh.growth = this->current.growth;
+			this->previous.emplace(std::move(this->current));
+			this->current = std::move(fresh);
+
+			const size_t limit = this->current.growth.entriesBelow(this->current.capacity());
+			const size_t headroom = (limit > this->previous->size()) ? limit - this->previous->size() : 1;
+			const size_t oldCapacity = this->previous->capacity();
+			this->cursor = 0;
+			this->step = std::max(MIN_MIGRATION_STEP, (oldCapacity + headroom - 1) / headroom);
+		}
+
+		/** Moves up to `step` buckets of the previous table into the current one. */
+		void migrate() {
+			if (!this->previous) {return;}
+
+			std::vector<Bucket> &oldTableData = this->previous->tableData;
+			const size_t end = std::min(oldTableData.size(), this->cursor + this->step);
+			for (; this->cursor < end; ++this->cursor) {
+				Bucket &bucket = oldTableData[this->cursor];
+				if (bucket.isEmpty()) {continue;}
+				this->current.place(std::move(bucket));
+				++this->current.length;
+				bucket.makeEAR();
+				--this->previous->length;
+			}
+
+			if (this->cursor == oldTableData.size()) {this->previous.reset();}
+		}
+};
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ *	HashTableKey.h
+ *
+ *	Key storage policies for `HashTableBucket`, chosen at compile time with
+ *	`HASHTABLE_KEY_STORAGE`:
+ *	-	`InlineKey`: a 16-byte slot. Keys of up to 15 bytes are stored inside
+ *		the slot; longer keys are copied into the table's `StringArena`, and
+ *		the slot keeps their address and length.
+ *	-	`StringKey`: a `std::string`, with a heap block for every key longer
+ *		than the library's own small-string buffer.
+ *
+ *	Every key storage provides:
+ *	-	`view()`: the stored key.
+ *	-	`assign(key, arena)`: stores a copy of `key`, using `arena` if needed.
+ *	-	`external()`: `true` if the stored key lives in the arena.
+ *	-	`state()` / `setState(state)`: two spare bits for the bucket type, so
+ *		`InlineKey` can keep them in its tag byte.
+ */
+
+#ifndef HASHTABLEKEY_H
+#define HASHTABLEKEY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ *	Bump allocator for long keys. Keys are copied back to back into chunks
+ *	of at least `CHUNK_SIZE` bytes taken from a `std::pmr::memory_resource`.
+ *	Chunks are never freed one key at a time: `clear()` and the destructor
+ *	hand all of them back at once, in `O(chunks)`. The bytes of removed keys
+ *	stay behind until the owner copies its live keys into a fresh arena.
+ */
+class StringArena {
+	public:
+		static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+		explicit StringArena(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+			: resource(resource) {}
+
+		StringArena(const StringArena &) = delete;
+		StringArena & operator=(const StringArena &) = delete;
+
+		/** The chunks move along with the resource they came from, so stored keys stay valid. */
+		StringArena(StringArena &&other) noexcept
+			: resource(other.resource),
+			chunks(std::move(other.chunks)),
+			next(std::exchange(other.next, nullptr)),
+			remaining(std::exchange(other.remaining, 0)),
+			used(std::exchange(other.used, 0)),
+			reserved(std::exchange(other.reserved, 0)) {
+			other.chunks.clear();
+		}
+
+		StringArena & operator=(StringArena &&other) noexcept {
+			if (this != &other) {
+				this->clear();
+				this->resource = other.resource;
+				this->chunks = std::move(other.chunks);
+				this->next = std::exchange(other.next, nullptr);
+				this->remaining = std::exchange(other.remaining, 0);
+				this->used = std::exchange(other.used, 0);
+				this->reserved = std::exchange(other.reserved, 0);
+				other.chunks.clear();
+			}
+			return *this;
+		}
+
+		~StringArena() {this->clear();}
+
+		/** Copies `text` into the arena and returns the copy, which stays put until the arena is cleared. */
+		std::string_view store(std::string_view text) {
+			if (text.size() > this->remaining) {this->grow(text.size());}
+			char *copy = this->next;
+			std::memcpy(copy, text.data(), text.size());
+			this->next += text.size();
+			this->remaining -= text.size();
+			this->used += text.size();
+			return std::string_view(copy, text.size());
+		}
+
+		/**
+		 *	Takes over every chunk of `other`, which must draw from the same
+		 *	memory resource. Keys stored in `other` stay valid, and `other` is
+		 *	left empty.
+		 */
+		void adopt(StringArena &&other) {
+			this->chunks.insert(this->chunks.end(), other.chunks.begin(), other.chunks.end());
+			this->used += std::exchange(other.used, 0);
+			this->reserved += std::exchange(other.reserved, 0);
+			other.chunks.clear();
+			other.next = nullptr;
+			other.remaining = 0;
+		}
+
+		/** Frees every chunk, which invalidates every stored key. */
+		void clear() {
+			for (const Chunk &chunk : this->chunks) {this->resource->deallocate(chunk.data, chunk.size, 1);}
+			this->chunks.clear();
+			this->next = nullptr;
+			this->remaining = 0;
+			this->used = 0;
+			this->reserved = 0;
+		}
+
+		/** Returns the number of key bytes stored since the last `clear()`. */
+		size_t bytesUsed() const {return this->used;}
+
+		/** Returns the number of bytes held in chunks, including the unused tail of the last one. */
+		size_t bytesReserved() const {return this->reserved;}
+
+	private:
+		struct Chunk {
+			char *data;
+			size_t size;
+		};
+
+		std::pmr::memory_resource *resource;
+		std::vector<Chunk> chunks;
+		char *next = nullptr;
+		size_t remaining = 0;
+		size_t used = 0;
+		size_t reserved = 0;
+
+		/** Starts a new chunk that holds at least `size` bytes. */
+		void grow(size_t size) {
+			const size_t chunkSize = std::max(CHUNK_SIZE, size);
+			char *data = static_cast<char *>(this->resource->allocate(chunkSize, 1));
+			this->chunks.push_back(Chunk{data, chunkSize});
+			this->next = data;
+			this->remaining = chunkSize;
+			this->reserved += chunkSize;
+		}
+};
+
+/**
+ *	Fixed 16-byte key slot. The last byte is a tag holding the bucket type
+ *	(top two bits), whether the key lives in the arena, and the length of an
+ *	inline key. An arena key keeps its address and a 32-bit length instead,
+ *	so keys are limited to 4 GiB.
+ */
+class InlineKey {
+	public:
+		static constexpr size_t CAPACITY = 15;
+
+		InlineKey() : bytes{} {}
+
+		std::string_view view() const {
+			if (this->bytes[TAG] & EXTERNAL) {
+				const char *data;
+				uint32_t length;
+				std::memcpy(&data, this->bytes, sizeof(data));
+				std::memcpy(&length, this->bytes + sizeof(data), sizeof(length));
+				return std::string_view(data, length);
+			}
+			return std::string_view(reinterpret_cast<const char *>(this->bytes), this->bytes[TAG] & LENGTH);
+		}
+
+		bool external() const {return (this->bytes[TAG] & EXTERNAL) != 0;}
+
+		void assign(std::string_view key, StringArena &arena) {
+			const unsigned char state = this->bytes[TAG] & STATE;
+			if (key.size() <= CAPACITY) {
+				std::memmove(this->bytes, key.data(), key.size());
+				this->bytes[TAG] = static_cast<unsigned char>(state | key.size());
+			} else {
+				const char *data = arena.store(key).data();
+				const uint32_t length = static_cast<uint32_t>(key.size());
+				std::memcpy(this->bytes, &data, sizeof(data));
+				std::memcpy(this->bytes + sizeof(data), &length, sizeof(length));
+				this->bytes[TAG] = state | EXTERNAL;
+			}
+		}
+
+		unsigned char state() const {return this->bytes[TAG] >> 6;}
+
+		void setState(unsigned char state) {
+			this->bytes[TAG] = static_cast<unsigned char>((this->bytes[TAG] & ~STATE) | (state << 6));
+		}
+
+	private:
+		static constexpr size_t TAG = CAPACITY;
+		static constexpr unsigned char LENGTH = 0x0f;
+		static constexpr unsigned char EXTERNAL = 0x10;
+		static constexpr unsigned char STATE = 0xc0;
+
+		alignas(8) unsigned char bytes[CAPACITY + 1];
+};
+
+/** The original `std::string` key, with the bucket type in its own byte. */
+class StringKey {
+	public:
+		std::string_view view() const {return this->key;}
+
+		void assign(std::string_view key, StringArena &) {this->key = key;}
+
+		bool external() const {return false;}
+
+		unsigned char state() const {return this->bucketState;}
+
+		void setState(unsigned char state) {this->bucketState = state;}
+
+	private:
+		std::string key;
+		unsigned char bucketState = 0;
+};
+
+#endif
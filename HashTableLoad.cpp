@@ -0,0 +1,65 @@
+/**
+ *	HashTableLoad.cpp
+ *
+ *	Loads a `key,value` text file into a `HashTable` with the streaming
+ *	loader and prints timing, memory and `HashTable::stats()`.
+ *
+ *	Usage: `HashTableLoad <file> [separator] [image]`. The separator
+ *	defaults to `,`; if an image path is given, the table is also saved
+ *	there with `HashTable::save`.
+ */
+
+#include "HashTable.h"
+#include "HashTableBenchUtil.h"
+#include "HashTableLoader.h"
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s <file> [separator] [image]\n", argv[0]);
+		return 1;
+	}
+	const std::string path = argv[1];
+	const char separator = (argc > 2 && argv[2][0] != '\0') ? argv[2][0] : ',';
+
+	HashTable table;
+	LoadStats stats;
+	try {
+		stats = loadKeyValueFile(table, path, separator);
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "%s\n", error.what());
+		return 1;
+	}
+
+	const double megabytes = static_cast<double>(stats.bytes) / (1024.0 * 1024.0);
+	std::printf("load\n");
+	std::printf("  rows            %zu (%zu new keys)\n", stats.rows, stats.newKeys);
+	std::printf("  malformed rows  %zu", stats.malformedRows);
+	if (stats.malformedRows > 0) {std::printf(" (first on line %zu)", stats.firstMalformedLine);}
+	std::printf("\n");
+	std::printf("  read            %.1f MiB in %.3f s\n", megabytes, stats.seconds);
+	std::printf("  throughput      %.0f rows/s, %.1f MiB/s\n", stats.rowsPerSecond(), (stats.seconds > 0.0) ? megabytes / stats.seconds : 0.0);
+
+	std::printf("\nmemory\n");
+	std::printf("  peak resident   %.1f MiB\n", static_cast<double>(peakResidentBytes()) / (1024.0 * 1024.0));
+
+	std::cout << "\ntable\n" << table.stats() << std::flush;
+
+	if (argc > 3) {
+		const auto start = std::chrono::steady_clock::now();
+		try {
+			table.save(argv[3]);
+		} catch (const std::exception &error) {
+			std::fprintf(stderr, "%s\n", error.what());
+			return 1;
+		}
+		std::printf("\nsaved %s in %.3f s\n", argv[3], std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ *	HashTableLoader.cpp
+ */
+
+#include "HashTableLoader.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ *	Parses one line into `entry`. Returns `false` if the line has no
+ *	separator or its value is not a whole decimal `size_t`.
+ */
+bool parseRow(std::string_view line, char separator, std::pair<std::string_view, size_t> &entry) {
+	const size_t split = line.rfind(separator);
+	if (split == std::string_view::npos) {return false;}
+
+	const char *first = line.data() + split + 1, *last = line.data() + line.size();
+	const auto [end, error] = std::from_chars(first, last, entry.second);
+	if (error != std::errc() || end != last || first == last) {return false;}
+
+	entry.first = line.substr(0, split);
+	return true;
+}
+
+/**
+ *	Each block is read after the unfinished last line of the previous block,
+ *	which is moved to the front of the buffer first, so every parsed line is
+ *	contiguous. A line longer than `BLOCK_SIZE` cannot be completed: it is
+ *	counted as malformed and skipped up to its end.
+ */
+LoadStats loadKeyValueFile(HashTable &table, const std::string &path, char separator) {
+	std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "rb"), &std::fclose);
+	if (!file) {throw std::runtime_error("cannot open " + path);}
+
+	LoadStats stats;
+	const auto start = std::chrono::steady_clock::now();
+
+	std::unique_ptr<char[]> buffer(new char[BLOCK_SIZE]);
+	std::vector<std::pair<std::string_view, size_t>> entries;
+	size_t carried = 0, line = 0;
+	bool endOfFile = false, skippingLine = false;
+
+	auto malformed = [&stats, &line]() {
+		++stats.malformedRows;
+		if (stats.firstMalformedLine == 0) {stats.firstMalformedLine = line;}
+	};
+
+	while (!endOfFile) {
+		const size_t read = std::fread(buffer.get() + carried, 1, BLOCK_SIZE - carried, file.get());
+		if (read < BLOCK_SIZE - carried) {
+			if (std::ferror(file.get())) {throw std::runtime_error("cannot read " + path);}
+			endOfFile = true;
+		}
+		stats.bytes += read;
+
+		std::string_view block(buffer.get(), carried + read);
+		if (skippingLine) {
+			const size_t lineEnd = block.find('\n');
+			block.remove_prefix((lineEnd == std::string_view::npos) ? block.size() : lineEnd + 1);
+			skippingLine = (lineEnd == std::string_view::npos);
+		}
+
+		entries.clear();
+		while (!block.empty()) {
+			size_t lineEnd = block.find('\n');
+			if (lineEnd == std::string_view::npos) {
+				if (endOfFile) {lineEnd = block.size();}
+				else if (block.size() == BLOCK_SIZE) {
+					++line;
+					malformed();
+					skippingLine = true;
+					block = std::string_view();
+					break;
+				} else {break;}
+			}
+
+			std::string_view row = block.substr(0, lineEnd);
+			block.remove_prefix(std::min(lineEnd + 1, block.size()));
+			++line;
+
+			if (!row.empty() && row.back() == '\r') {row.remove_suffix(1);}
+			if (row.empty()) {continue;}
+
+			std::pair<std::string_view, size_t> entry;
+			if (parseRow(row, separator, entry)) {entries.push_back(entry);}
+			else {malformed();}
+		}
+
+		stats.rows += entries.size();
+		stats.newKeys += table.insert_range(entries);
+
+		carried = block.size();
+		if (carried > 0) {std::memmove(buffer.get(), block.data(), carried);}
+	}
+
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
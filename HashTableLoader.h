@@ -0,0 +1,44 @@
+/**
+ *	HashTableLoader.h
+ */
+
+#ifndef HASHTABLELOADER_H
+#define HASHTABLELOADER_H
+
+#include <string>
+#include "HashTable.h"
+
+/** What `loadKeyValueFile` read and how long it took. */
+struct LoadStats {
+	size_t rows = 0;
+	size_t newKeys = 0;
+	size_t malformedRows = 0;
+	size_t bytes = 0;
+	double seconds = 0.0;
+
+	/** 1-based line number of the first malformed row, or `0` if there was none. */
+	size_t firstMalformedLine = 0;
+
+	double rowsPerSecond() const {return (this->seconds > 0.0) ? static_cast<double>(this->rows) / this->seconds : 0.0;}
+};
+
+/**
+ *	Streams a text file of `key<separator>value` lines into `table`, where
+ *	`value` is a decimal `size_t`. The key is everything before the last
+ *	separator of the line, so keys may contain the separator themselves.
+ *	A trailing `\r` is ignored and empty lines are skipped.
+ *
+ *	The file is read in blocks of `BLOCK_SIZE` bytes. Each block is parsed in
+ *	place into `std::string_view` keys and `std::from_chars` values, and the
+ *	whole block goes into the table with one `HashTable::insert_range` call,
+ *	so nothing is copied before the table stores the key. A line that does
+ *	not parse is counted in `malformedRows` and skipped.
+ *
+ *	Throws `std::runtime_error` if the file cannot be read.
+ */
+LoadStats loadKeyValueFile(HashTable &table, const std::string &path, char separator = ',');
+
+/** Bytes read from the file per block. A single line must fit in one block. */
+constexpr size_t BLOCK_SIZE = 16 * 1024 * 1024;
+
+#endif
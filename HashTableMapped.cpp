@@ -0,0 +1,218 @@
+/**
+ *	HashTableMapped.cpp
+ */
+
+#include "HashTableMapped.h"
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ *	Maps the image at `path` read-only and checks its header: the magic,
+ *	version, byte order and header checksum, that the image was saved with
+ *	the probing and indexing strategies and key hash of this build, and
+ *	that the file holds exactly the buckets and key bytes it announces.
+ *	Throws `std::runtime_error` if any check fails.
+ *
+ *	The bucket records and keys are not read here; `verify()` checks them.
+ */
+MappedHashTable::MappedHashTable(const std::string &path) {
+#ifdef _WIN32
+	this->fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (this->fileHandle == INVALID_HANDLE_VALUE) {
+		this->fileHandle = nullptr;
+		throw std::runtime_error("cannot open " + path);
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(this->fileHandle, &fileSize);
+	this->mappingSize = static_cast<size_t>(fileSize.QuadPart);
+	if (this->mappingSize < sizeof(HashTableImage::Header)) {
+		this->unmap();
+		throw std::runtime_error(path + " is too small to be a HashTable image");
+	}
+	this->mappingHandle = CreateFileMappingA(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	this->mapping = (this->mappingHandle != nullptr) ? MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (this->mapping == nullptr) {
+		this->unmap();
+		throw std::runtime_error("cannot map " + path);
+	}
+#else
+	const int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {throw std::runtime_error("cannot open " + path);}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(HashTableImage::Header)) {
+		close(descriptor);
+		throw std::runtime_error(path + " is too small to be a HashTable image");
+	}
+	this->mappingSize = static_cast<size_t>(status.st_size);
+	void *address = mmap(nullptr, this->mappingSize, PROT_READ, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+	if (address == MAP_FAILED) {throw std::runtime_error("cannot map " + path);}
+	this->mapping = address;
+#endif
+
+	const HashTableImage::Header &image = *static_cast<const HashTableImage::Header *>(this->mapping);
+	const char *problem = nullptr;
+	if (std::memcmp(image.magic, HashTableImage::MAGIC, sizeof(image.magic)) != 0) {problem = "is not a HashTable image";}
+	else if (image.version != HashTableImage::VERSION) {problem = "has an unsupported image version";}
+	else if (image.byteOrder != HashTableImage::ENDIAN_MARK) {problem = "was saved with a different byte order";}
+	else if (image.headerChecksum != HashTableImage::headerChecksum(image)) {problem = "has a corrupt header";}
+	else if (std::strncmp(image.probing, HashTableImage::PROBING_NAME, HashTableImage::NAME_SIZE) != 0) {problem = "was saved with a different probing strategy";}
+	else if (std::strncmp(image.indexing, HashTableImage::INDEXING_NAME, HashTableImage::NAME_SIZE) != 0) {problem = "was saved with a different indexing strategy";}
+	else if ((!Hash::seeded && image.hashSeed != 0) || image.hashCheck != Hash(image.hashSeed)(HashTableImage::HASH_CHECK_KEY)) {problem = "was saved with a different key hash";}
+	else if (image.capacity == 0 || Indexing::roundCapacity(image.capacity) != image.capacity || image.size >= image.capacity) {problem = "has an invalid capacity";}
+	else if (image.capacity > (this->mappingSize - sizeof(HashTableImage::Header)) / sizeof(HashTableImage::Bucket)
+		|| this->mappingSize != sizeof(HashTableImage::Header) + image.capacity * sizeof(HashTableImage::Bucket) + image.keyBytes) {problem = "is truncated";}
+
+	if (problem != nullptr) {
+		this->unmap();
+		throw std::runtime_error(path + " " + problem);
+	}
+
+	this->header = &image;
+	this->buckets = reinterpret_cast<const HashTableImage::Bucket *>(this->header + 1);
+	this->keyData = reinterpret_cast<const char *>(this->buckets + image.capacity);
+	this->hasher = Hash(image.hashSeed);
+	if (Hash::seeded) {seedProbing(this->probing, image.hashSeed);}
+	this->indexing.reset(image.capacity);
+	this->probing.reset(image.capacity);
+}
+
+MappedHashTable::MappedHashTable(MappedHashTable &&other) noexcept
+	: mapping(std::exchange(other.mapping, nullptr)),
+	mappingSize(std::exchange(other.mappingSize, 0)),
+#ifdef _WIN32
+	fileHandle(std::exchange(other.fileHandle, nullptr)),
+	mappingHandle(std::exchange(other.mappingHandle, nullptr)),
+#endif
+	header(std::exchange(other.header, nullptr)),
+	buckets(std::exchange(other.buckets, nullptr)),
+	keyData(std::exchange(other.keyData, nullptr)),
+	indexing(other.indexing),
+	probing(std::move(other.probing)),
+	hasher(other.hasher) {}
+
+MappedHashTable & MappedHashTable::operator=(MappedHashTable &&other) noexcept {
+	if (this != &other) {
+		this->unmap();
+		this->mapping = std::exchange(other.mapping, nullptr);
+		this->mappingSize = std::exchange(other.mappingSize, 0);
+#ifdef _WIN32
+		this->fileHandle = std::exchange(other.fileHandle, nullptr);
+		this->mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+		this->header = std::exchange(other.header, nullptr);
+		this->buckets = std::exchange(other.buckets, nullptr);
+		this->keyData = std::exchange(other.keyData, nullptr);
+		this->indexing = other.indexing;
+		this->probing = std::move(other.probing);
+		this->hasher = other.hasher;
+	}
+	return *this;
+}
+
+MappedHashTable::~MappedHashTable() {this->unmap();}
+
+/** Releases the mapping and, on Windows, the handles behind it. */
+void MappedHashTable::unmap() {
+#ifdef _WIN32
+	if (this->mapping != nullptr) {UnmapViewOfFile(this->mapping);}
+	if (this->mappingHandle != nullptr) {CloseHandle(this->mappingHandle);}
+	if (this->fileHandle != nullptr) {CloseHandle(this->fileHandle);}
+	this->fileHandle = nullptr;
+	this->mappingHandle = nullptr;
+#else
+	if (this->mapping != nullptr) {munmap(const_cast<void *>(this->mapping), this->mappingSize);}
+#endif
+	this->mapping = nullptr;
+	this->header = nullptr;
+}
+
+/**
+ *	Probes the mapped buckets like `HashTable::get`. Bucket records are only
+ *	trusted as far as the header was checked, so a key that would lie past
+ *	the key bytes never matches, and the probe gives up after `capacity`
+ *	buckets instead of relying on an `ESS` bucket to end it.
+ */
+const HashTableImage::Bucket * MappedHashTable::find(std::string_view key) const {
+	const size_t keyHash = this->hasher(key);
+	ProbeCursor probe = this->probing.begin(keyHash, this->indexing);
+
+	for (size_t probes = 0; probes < this->capacity(); ++probes) {
+		const HashTableImage::Bucket &bucket = this->buckets[probe.index];
+		if (bucket.state == HashTableImage::ESS) {return nullptr;}
+		if (bucket.state == HashTableImage::NORMAL && bucket.hash == keyHash && bucket.keyLength == key.size()
+			&& this->keyInBounds(bucket) && std::memcmp(this->keyData + bucket.keyOffset, key.data(), key.size()) == 0) {return &bucket;}
+		this->probing.advance(probe, this->indexing);
+	}
+	return nullptr;
+}
+
+/** Returns `true` if the key of a bucket record lies within the key bytes of the image. */
+bool MappedHashTable::keyInBounds(const HashTableImage::Bucket &bucket) const {
+	return bucket.keyLength <= this->header->keyBytes && bucket.keyOffset <= this->header->keyBytes - bucket.keyLength;
+}
+
+/** @brief Returns `true` if and only if a specified key exists in the image. */
+bool MappedHashTable::contains(std::string_view key) const {
+	return this->find(key) != nullptr;
+}
+
+/**
+ *	If the key is found in the image, return the value that is associated
+ *	with that key. Otherwise, returns `nullopt`.
+ */
+std::optional<size_t> MappedHashTable::get(std::string_view key) const {
+	const HashTableImage::Bucket *bucket = this->find(key);
+	if (bucket == nullptr) {return std::nullopt;}
+	return static_cast<size_t>(bucket->value);
+}
+
+/**
+ *	Returns a vector of keys in the image, in bucket order. Like `find`, it
+ *	skips a bucket record whose key would lie past the key bytes.
+ */
+std::vector<std::string> MappedHashTable::keys() const {
+	std::vector<std::string> keyList;
+	keyList.reserve(this->size());
+	for (size_t bucketIndex = 0; bucketIndex < this->capacity(); ++bucketIndex) {
+		const HashTableImage::Bucket &bucket = this->buckets[bucketIndex];
+		if (bucket.state == HashTableImage::NORMAL && this->keyInBounds(bucket)) {keyList.emplace_back(this->keyData + bucket.keyOffset, bucket.keyLength);}
+	}
+	return keyList;
+}
+
+/** Returns the load factor of the image, which is `size / capacity`. */
+double MappedHashTable::alpha() const {
+	return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
+}
+
+/** Returns the number of buckets in the image. */
+size_t MappedHashTable::capacity() const {
+	return static_cast<size_t>(this->header->capacity);
+}
+
+/** Returns the number of key-value pairs in the image. */
+size_t MappedHashTable::size() const {
+	return static_cast<size_t>(this->header->size);
+}
+
+/**
+ *	Returns `true` if the bucket records and key bytes match the checksum
+ *	in the header. Reads the whole image, in `O(n)`.
+ */
+bool MappedHashTable::verify() const {
+	const size_t payloadSize = this->mappingSize - sizeof(HashTableImage::Header);
+	return HashTableImage::checksum(this->buckets, payloadSize) == this->header->payloadChecksum;
+}
@@ -0,0 +1,158 @@
+/**
+ *	HashTableMapped.h
+ *
+ *	Binary image of a `HashTable`, written by `HashTable::save` and read in
+ *	place by `MappedHashTable`. The image is the header, then one 32-byte
+ *	record per bucket, then every key back to back:
+ *
+ *		Header | Bucket[capacity] | key bytes
+ *
+ *	The bucket array keeps the layout of the saved table, so a lookup in the
+ *	image follows the same probe sequence as in the table, as long as the
+ *	reader is built with the same probing and indexing strategies and the
+ *	same key hash. The header records all three, with the seed of a seeded
+ *	key hash, and `MappedHashTable` refuses an image that does not match.
+ *	The seed is what keeps hash codes unpredictable, so an image of a table
+ *	keyed by untrusted strings must be kept as private as the table. Numbers
+ *	are stored in the byte order of the machine that saved the image.
+ */
+
+#ifndef HASHTABLEMAPPED_H
+#define HASHTABLEMAPPED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "HashTable.h"
+
+#define HASHTABLE_STRINGIFY(name) #name
+#define HASHTABLE_NAME(name) HASHTABLE_STRINGIFY(name)
+
+namespace HashTableImage {
+	constexpr char MAGIC[8] = {'H', 'T', 'I', 'M', 'A', 'G', 'E', '\0'};
+	constexpr uint32_t VERSION = 1;
+	constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+	/** Name of each strategy, matched exactly when an image is opened. */
+	constexpr size_t NAME_SIZE = 32;
+	constexpr const char *PROBING_NAME = HASHTABLE_NAME(HASHTABLE_PROBING);
+	constexpr const char *INDEXING_NAME = HASHTABLE_NAME(HASHTABLE_INDEXING);
+
+	/** Bucket states, in the order of `HashTableBucket::BucketType`. */
+	enum State : uint8_t {NORMAL, ESS, EAR};
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint64_t capacity;
+		uint64_t size;
+		uint64_t keyBytes;
+
+		/** Seed of the key hash, `0` for an unseeded hash like `StringHash`. */
+		uint64_t hashSeed;
+
+		/** Hash of `HASH_CHECK_KEY`, which differs if the reader hashes keys differently. */
+		uint64_t hashCheck;
+
+		char probing[NAME_SIZE];
+		char indexing[NAME_SIZE];
+
+		/** Checksum of the bucket records and the key bytes. */
+		uint64_t payloadChecksum;
+
+		/** Checksum of every header field above. */
+		uint64_t headerChecksum;
+	};
+
+	/** A bucket of the saved table. Normal buckets point into the key bytes. */
+	struct Bucket {
+		uint64_t hash;
+		uint64_t value;
+		uint64_t keyOffset;
+		uint32_t keyLength;
+		uint8_t state;
+		uint8_t padding[3];
+	};
+
+	static_assert(sizeof(Header) % alignof(Bucket) == 0, "bucket records must stay aligned after the header");
+	static_assert(sizeof(Bucket) == 32, "bucket records should be 32 bytes");
+
+	constexpr std::string_view HASH_CHECK_KEY = "HashTableImage";
+
+	constexpr uint64_t CHECKSUM_SEED = 0xcbf29ce484222325ULL;
+
+	/** 64-bit FNV-1a of `size` bytes, continued from `checksum`. */
+	inline uint64_t checksum(const void *data, size_t size, uint64_t checksum = CHECKSUM_SEED) {
+		const unsigned char *bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i) {
+			checksum ^= bytes[i];
+			checksum *= 0x100000001b3ULL;
+		}
+		return checksum;
+	}
+
+	/** Returns the header checksum of `header`, over every field before `headerChecksum`. */
+	inline uint64_t headerChecksum(const Header &header) {
+		return checksum(&header, offsetof(Header, headerChecksum));
+	}
+}
+
+/**
+ *	Read-only `HashTable` backed by a memory-mapped image. Opening checks the
+ *	header and maps the file, which takes the same time for any table size;
+ *	`get` and `contains` then probe the mapped bucket records directly, and
+ *	pages are only read from disk as lookups touch them.
+ */
+class MappedHashTable {
+	public:
+		using Probing = HashTable::Probing;
+		using Indexing = HashTable::Indexing;
+		using Hash = HashTable::Hash;
+
+		explicit MappedHashTable(const std::string &path);
+
+		MappedHashTable(const MappedHashTable &) = delete;
+		MappedHashTable & operator=(const MappedHashTable &) = delete;
+		MappedHashTable(MappedHashTable &&other) noexcept;
+		MappedHashTable & operator=(MappedHashTable &&other) noexcept;
+		~MappedHashTable();
+
+		bool contains(std::string_view key) const;
+
+		std::optional<size_t> get(std::string_view key) const;
+
+		std::vector<std::string> keys() const;
+
+		double alpha() const;
+
+		size_t capacity() const;
+		size_t size() const;
+
+		bool verify() const;
+
+	private:
+		const void *mapping = nullptr;
+		size_t mappingSize = 0;
+#ifdef _WIN32
+		void *fileHandle = nullptr;
+		void *mappingHandle = nullptr;
+#endif
+
+		const HashTableImage::Header *header = nullptr;
+		const HashTableImage::Bucket *buckets = nullptr;
+		const char *keyData = nullptr;
+
+		Indexing indexing;
+		Probing probing;
+		Hash hasher;
+
+		const HashTableImage::Bucket * find(std::string_view key) const;
+		bool keyInBounds(const HashTableImage::Bucket &bucket) const;
+		void unmap();
+};
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ *	HashTableProbeBench.cpp
+ *
+ *	Compares probe lengths and lookup times of the one-bucket-at-a-time
+ *	`HashTable` against `FlatHashtable_t`, probing its control bytes one at a
+ *	time (`LinearProbing`) and one group at a time (`GroupProbing`). Hits are
+ *	timed once with `contains` per key and once with the prefetching
+ *	`contains_many` over the whole key set.
+ *
+ *	Usage: `HashTableProbeBench [log2 capacity]`, default `20`.
+ */
+
+#include "HashTable.h"
+#include "HashTableBenchUtil.h"
+#include "HashTableFlat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using FlatScalar = FlatHashtable_t<std::string, size_t, StringHash, std::equal_to<>, LinearProbing>;
+using FlatGrouped = FlatHashtable_t<std::string, size_t, StringHash, std::equal_to<>, GroupProbing>;
+
+/** Mean and maximum probe length, and nanoseconds per lookup one by one and batched, over a key set. */
+struct ProbeSummary {
+	double meanProbes;
+	size_t maxProbes;
+	double nanosPerLookup;
+	double nanosPerBatchedLookup;
+};
+
+template<typename Table>
+ProbeSummary summarize(const Table &table, const std::vector<std::string> &keys) {
+	size_t totalProbes = 0, maxProbes = 0;
+	for (const std::string &key : keys) {
+		const size_t probes = table.probeLength(key);
+		totalProbes += probes;
+		maxProbes = std::max(maxProbes, probes);
+	}
+
+	size_t found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (const std::string &key : keys) {found += table.contains(key);}
+	const double nanosPerLookup = nanosPerKey(start, keys.size());
+
+	const std::vector<std::string_view> views(keys.begin(), keys.end());
+	const std::unique_ptr<bool[]> results(new bool[keys.size()]);
+	start = std::chrono::steady_clock::now();
+	table.contains_many(std::span<const std::string_view>(views), std::span<bool>(results.get(), keys.size()));
+	const double nanosPerBatchedLookup = nanosPerKey(start, keys.size());
+	found += static_cast<size_t>(std::count(results.get(), results.get() + keys.size(), true));
+
+	// Keeps the lookup loops from being optimized away.
+	if (found == static_cast<size_t>(-1)) {std::puts("");}
+
+	return ProbeSummary{
+		static_cast<double>(totalProbes) / static_cast<double>(keys.size()),
+		maxProbes,
+		nanosPerLookup,
+		nanosPerBatchedLookup
+	};
+}
+
+template<typename Table>
+void measure(const char *name, const char *unit, size_t capacity, const std::vector<std::string> &hits, const std::vector<std::string> &misses) {
+	Table table(capacity);
+	table.max_load_factor(0.9);
+	for (size_t i = 0; i < hits.size(); ++i) {table.insert(hits[i], i);}
+
+	const ProbeSummary hit = summarize(table, hits);
+	const ProbeSummary miss = summarize(table, misses);
+	std::printf("%-22s %6.3f %10.3f %8zu %10.3f %8zu %10.1f %10.1f %10.1f %10.1f  %s\n",
+		name, table.alpha(), hit.meanProbes, hit.maxProbes, miss.meanProbes, miss.maxProbes,
+		hit.nanosPerLookup, miss.nanosPerLookup, hit.nanosPerBatchedLookup, miss.nanosPerBatchedLookup, unit);
+}
+
+int main(int argc, char **argv) {
+	const unsigned log2Capacity = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : 20;
+	const size_t capacity = size_t{1} << log2Capacity;
+
+	std::mt19937_64 random(42);
+	auto randomKey = [&random]() {return "key:" + std::to_string(random());};
+
+	std::printf("capacity %zu, group width %zu, * = contains_many in batches of %zu\n\n", capacity, Group::WIDTH, PREFETCH_BATCH);
+	std::printf("%-22s %6s %10s %8s %10s %8s %10s %10s %10s %10s\n",
+		"table", "alpha", "hit mean", "hit max", "miss mean", "miss max", "ns/hit", "ns/miss", "ns/hit*", "ns/miss*");
+
+	// The tables grow at alpha 0.9 here, so every row is measured at the capacity given.
+	for (const double alpha : {0.25, 0.5, 0.75, 0.875}) {
+		std::vector<std::string> hits(static_cast<size_t>(alpha * static_cast<double>(capacity)));
+		std::vector<std::string> misses(hits.size());
+		for (std::string &key : hits) {key = randomKey();}
+		for (std::string &key : misses) {key = randomKey();}
+
+		measure<HashTable>("HashTable", "buckets", capacity, hits, misses);
+		measure<FlatScalar>("FlatHashtable_t scalar", "buckets", capacity, hits, misses);
+		measure<FlatGrouped>("FlatHashtable_t group", "groups", capacity, hits, misses);
+		std::printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,318 @@
+/**
+ *	HashTableProbing.h
+ *
+ *	Indexing and probing strategies for the open-addressing tables.
+ *
+ *	An indexing strategy owns the capacity: it decides which capacities are
+ *	valid and reduces a hash code to a bucket index without `% capacity()`.
+ *	Every indexing strategy provides:
+ *	-	`powerOfTwo`: `true` if every capacity is a power of two.
+ *	-	`roundCapacity(n)`: the smallest valid capacity of at least `n`.
+ *	-	`reset(capacity)`: called whenever the capacity changes.
+ *	-	`home(hash)`: the bucket index at probe index `0`.
+ *	-	`wrap(index)`: reduces an index below `2 * capacity` into the table.
+ *	-	`stride(hash)`: a probe stride coprime with the capacity.
+ *
+ *	A probing strategy turns the home bucket into the sequence of bucket
+ *	indices visited by `insert`, `remove`, `contains`, `get` and `operator[]`.
+ *	Every probing strategy provides:
+ *	-	`requiresPowerOfTwo`: `true` if the sequence only covers every bucket
+ *		under a power-of-two indexing strategy.
+ *	-	`reset(capacity)`: called whenever the capacity changes.
+ *	-	`begin(hash, indexing)`: the cursor at probe index `0`.
+ *	-	`advance(cursor, indexing)`: moves the cursor to the next probe.
+ *	-	`backwardShift` (optional): `remove` closes the gap it leaves instead
+ *		of leaving an `EAR` tombstone.
+ */
+
+#ifndef HASHTABLEPROBING_H
+#define HASHTABLEPROBING_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <random>
+
+/**
+ *	Finalizer applied to raw hash codes before they are masked. `std::hash`
+ *	of an integer is the identity, and string hashes are not guaranteed to
+ *	be well mixed in their low bits, so every input bit is folded into every
+ *	output bit (the `fmix64` step of MurmurHash3).
+ */
+inline uint64_t mixHash(uint64_t hash) {
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+/** Keys whose home buckets are prefetched together by the batched lookups. */
+constexpr size_t PREFETCH_BATCH = 16;
+
+/**
+ *	Asks the CPU to start loading the cache line at `address` for reading,
+ *	so a probe issued a few keys later finds it in cache. Does nothing on
+ *	compilers without `__builtin_prefetch`.
+ */
+inline void prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address, 0, 3);
+#else
+	(void) address;
+#endif
+}
+
+/**
+ *	Capacities are powers of two and indices are taken with a mask. The hash
+ *	is finalized with `mixHash` first, so the masked low bits depend on the
+ *	whole hash code.
+ */
+class PowerOfTwoIndexing {
+	public:
+		static constexpr bool powerOfTwo = true;
+
+		static size_t roundCapacity(size_t capacity) {return std::bit_ceil(capacity > 0 ? capacity : 1);}
+
+		void reset(size_t capacity) {this->mask = capacity - 1;}
+
+		size_t capacity() const {return this->mask + 1;}
+
+		size_t home(size_t hash) const {return static_cast<size_t>(mixHash(hash)) & this->mask;}
+
+		size_t wrap(size_t index) const {return index & this->mask;}
+
+		/** Any odd stride is coprime with a power of two. */
+		size_t stride(size_t hash) const {
+			return (static_cast<size_t>(mixHash(hash) >> 32) & this->mask) | 1;
+		}
+
+	private:
+		size_t mask = 0;
+};
+
+/**
+ *	Capacities are primes and indices are reduced with Lemire's `fastmod`,
+ *	two multiplications instead of a division. A prime modulus spreads weak
+ *	hash codes by itself, so no finalizer is applied.
+ *
+ *	The hash is folded to 32 bits, so the capacity must stay below `2^32`.
+ */
+class PrimeIndexing {
+	public:
+		static constexpr bool powerOfTwo = false;
+
+		/** Returns the smallest prime that is at least `capacity`. */
+		static size_t roundCapacity(size_t capacity) {
+			if (capacity <= 2) {return 2;}
+			if (capacity % 2 == 0) {++capacity;}
+			while (!isPrime(capacity)) {capacity += 2;}
+			return capacity;
+		}
+
+		void reset(size_t capacity) {
+			this->divisor = capacity;
+			this->magic = UINT64_MAX / capacity + 1;
+			this->strideDivisor = (capacity > 1) ? capacity - 1 : 1;
+			this->strideMagic = UINT64_MAX / this->strideDivisor + 1;
+		}
+
+		size_t capacity() const {return this->divisor;}
+
+		size_t home(size_t hash) const {return fastmod(fold(hash), this->magic, this->divisor);}
+
+		size_t wrap(size_t index) const {return (index >= this->divisor) ? index - this->divisor : index;}
+
+		/** Every stride in `[1, capacity - 1]` is coprime with a prime capacity. */
+		size_t stride(size_t hash) const {
+			return 1 + fastmod(fold(mixHash(hash)), this->strideMagic, this->strideDivisor);
+		}
+
+	private:
+		uint64_t magic = 0, strideMagic = 0;
+		size_t divisor = 1, strideDivisor = 1;
+
+		static bool isPrime(size_t n) {
+			for (size_t d = 3; d * d <= n; d += 2) {
+				if (n % d == 0) {return false;}
+			}
+			return true;
+		}
+
+		static uint32_t fold(size_t hash) {
+			return static_cast<uint32_t>(static_cast<uint64_t>(hash) ^ (static_cast<uint64_t>(hash) >> 32));
+		}
+
+		/** Computes `a % d` given `magic = floor((2^64 - 1) / d) + 1`. */
+		static size_t fastmod(uint32_t a, uint64_t magic, size_t d) {
+#ifdef __SIZEOF_INT128__
+			const uint64_t lowbits = magic * a;
+			return static_cast<size_t>((static_cast<__uint128_t>(lowbits) * d) >> 64);
+#else
+			(void) magic;
+			return a % d;
+#endif
+		}
+};
+
+/**
+ *	Position within a probe sequence. `index` is the bucket to inspect,
+ *	`probe` counts the buckets inspected before it.
+ */
+struct ProbeCursor {
+	size_t home;
+	size_t index;
+	size_t step;
+	size_t probe;
+};
+
+/**
+ *	Visits `home, home + 1, home + 2, ...`. Neighbouring buckets share cache
+ *	lines, and it works for any capacity.
+ */
+struct LinearProbing {
+	static constexpr bool requiresPowerOfTwo = false;
+
+	void reset(size_t) {}
+
+	template<typename Indexing>
+	ProbeCursor begin(size_t hash, const Indexing &indexing) const {
+		const size_t home = indexing.home(hash);
+		return ProbeCursor{home, home, 1, 0};
+	}
+
+	template<typename Indexing>
+	void advance(ProbeCursor &cursor, const Indexing &indexing) const {
+		++cursor.probe;
+		cursor.index = indexing.wrap(cursor.index + 1);
+	}
+};
+
+/**
+ *	Linear probing with backward-shift deletion. `remove` moves later entries
+ *	of the cluster back into the gap until an `ESS` bucket or an entry already
+ *	at its home, so tombstones are never created.
+ */
+struct LinearShiftProbing : LinearProbing {
+	static constexpr bool backwardShift = true;
+};
+
+/** `true` if a probing strategy asks for backward-shift deletion. */
+template<typename Probing>
+constexpr bool usesBackwardShift = requires {Probing::backwardShift;};
+
+/** Returns `true` if `index` lies in the cyclic range `(from, to]`. */
+inline bool cyclicallyBetween(size_t from, size_t index, size_t to) {
+	return (from <= to) ? (from < index && index <= to) : (from < index || index <= to);
+}
+
+/**
+ *	Visits `home + 0, home + 1, home + 3, home + 6, ...` (triangular numbers).
+ *	On a power-of-two capacity the first `capacity` probes hit every bucket
+ *	exactly once, while breaking up the primary clusters of linear probing.
+ */
+struct TriangularProbing {
+	static constexpr bool requiresPowerOfTwo = true;
+
+	void reset(size_t) {}
+
+	template<typename Indexing>
+	ProbeCursor begin(size_t hash, const Indexing &indexing) const {
+		const size_t home = indexing.home(hash);
+		return ProbeCursor{home, home, 0, 0};
+	}
+
+	template<typename Indexing>
+	void advance(ProbeCursor &cursor, const Indexing &indexing) const {
+		++cursor.probe;
+		cursor.index = indexing.wrap(cursor.index + (cursor.probe & (indexing.capacity() - 1)));
+	}
+};
+
+/**
+ *	Visits `home, home + s, home + 2s, ...` where the stride `s` is derived
+ *	from the hash by the indexing strategy, which keeps it coprime with the
+ *	capacity so the sequence covers every bucket.
+ */
+struct DoubleHashProbing {
+	static constexpr bool requiresPowerOfTwo = false;
+
+	void reset(size_t) {}
+
+	template<typename Indexing>
+	ProbeCursor begin(size_t hash, const Indexing &indexing) const {
+		const size_t home = indexing.home(hash);
+		return ProbeCursor{home, home, indexing.stride(hash), 0};
+	}
+
+	template<typename Indexing>
+	void advance(ProbeCursor &cursor, const Indexing &indexing) const {
+		++cursor.probe;
+		cursor.index = indexing.wrap(cursor.index + cursor.step);
+	}
+};
+
+/**
+ *	The original pseudo-random permutation probing, kept for comparison.
+ *	It stores one offset per bucket and costs a dependent load per probe.
+ */
+struct PermutationProbing {
+	static constexpr bool requiresPowerOfTwo = false;
+
+	std::vector<size_t> offsets;
+
+	/** Seed of the shuffle. Tables with a seeded key hash replace it with theirs, see `seedProbing`. */
+	uint64_t seed = std::mt19937_64::default_seed;
+
+	/**
+	 *	Generates a vector of offsets using random number generation.
+	 *
+	 *	Index `0` of the offsets vector is always `0`, and other indices
+	 *	starting at `1` are shuffled in-place.
+	 */
+	void reset(size_t capacity) {
+		std::mt19937_64 s(this->seed);
+		this->offsets.resize(capacity);
+
+		// Each element in the offsets vector starts with the indices themselves.
+		for (size_t i = 0; i < this->offsets.size(); ++i) {this->offsets[i] = i;}
+
+		// Shuffling needs at least two offsets after index 0 to swap.
+		if (this->offsets.size() < 3) {return;}
+
+		// Then shuffle each element starting at index 1 with another element starting at index 1.
+		for (size_t i = 1; i < this->offsets.size(); ++i) {
+			// Offset cannot be 0 for a true swap under a subvector of length (size - 1).
+			const size_t randomOffset = 1 + s() % (this->offsets.size() - 2);
+			const size_t indexToSwap = 1 + (i + randomOffset - 1) % (this->offsets.size() - 1);
+			std::swap(this->offsets[indexToSwap], this->offsets[i]);
+		}
+	}
+
+	template<typename Indexing>
+	ProbeCursor begin(size_t hash, const Indexing &indexing) const {
+		const size_t home = indexing.home(hash);
+		return ProbeCursor{home, home, 0, 0};
+	}
+
+	template<typename Indexing>
+	void advance(ProbeCursor &cursor, const Indexing &indexing) const {
+		++cursor.probe;
+		if (cursor.probe == this->offsets.size()) {cursor.probe = 0;}
+		cursor.index = indexing.wrap(cursor.home + this->offsets[cursor.probe]);
+	}
+};
+
+/**
+ *	Gives a probing strategy that draws random numbers the seed of the key
+ *	hash, so its probe order differs between tables like the hash codes do.
+ *	Must be called before `reset`. Does nothing for the other strategies.
+ */
+template<typename Probing>
+void seedProbing(Probing &probing, uint64_t seed) {
+	if constexpr (requires {probing.seed;}) {probing.seed = seed;}
+}
+
+#endif
@@ -0,0 +1,440 @@
+/**
+ *	HashTableReplay.cpp
+ *
+ *	Replays a recorded operation trace against `HashTable` or one of the
+ *	other tables, and generates traces from synthetic access models.
+ *
+ *	A trace is a text file with one operation per line, and `#` comments:
+ *
+ *		i <key> <value>    insert, overwriting the value of an existing key
+ *		g <key>            get
+ *		r <key>            remove
+ *		u <key> <delta>    add `delta` to the value, inserting the key first if missing
+ *
+ *	Keys cannot contain whitespace. The trace is read into memory before the
+ *	replay, with every distinct key stored once, so the replay itself only
+ *	touches the table.
+ *
+ *	Usage:
+ *
+ *		HashTableReplay replay <trace> [table] [threads]
+ *		HashTableReplay generate <model> <operations> [keys] [seed]
+ *
+ *	`table` is one of `HashTable` (default), `FlatHashtable_t`,
+ *	`IncrementalHashtable_t`, `std::unordered_map`, `ShardedHashTable` and
+ *	`ConcurrentHashtable_t`; only the last two can be replayed by more than
+ *	one thread. With `threads` threads, thread `t` replays operations `t`,
+ *	`t + threads`, `t + 2 * threads` and so on.
+ *
+ *	The replay prints the throughput, the latency percentiles of each
+ *	operation type, the resize pauses, which are the operations during which
+ *	the capacity changed, and the peak resident memory. Run one table per
+ *	process, so the peak belongs to that table.
+ *
+ *	`generate` writes a trace to standard output from one of these models,
+ *	over a key space of `keys` keys (default `operations / 10`):
+ *
+ *		uniform    every key equally likely
+ *		zipf       keys drawn with a Zipf distribution of exponent 0.99
+ *		hotspot    90% of the operations on 10% of the keys
+ *		churn      a sliding window of `keys` live keys: each step inserts a
+ *		           new key, removes the oldest and reads two live keys
+ *
+ *	The first three mix 60% gets, 20% updates, 15% inserts and 5% removes.
+ */
+
+#include "HashTable.h"
+#include "HashTableBenchUtil.h"
+#include "HashTableConcurrent.h"
+#include "HashTableFlat.h"
+#include "HashTableIncremental.h"
+#include "HashTableSharded.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <latch>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum OpType : uint8_t {INSERT, GET, REMOVE, UPDATE, OP_TYPES};
+
+constexpr const char *OP_NAMES[OP_TYPES] = {"insert", "get", "remove", "update"};
+constexpr char OP_CODES[OP_TYPES] = {'i', 'g', 'r', 'u'};
+
+/** One operation of a trace. `key` indexes the distinct keys of the trace. */
+struct Op {
+	uint64_t value;
+	uint32_t key;
+	OpType type;
+};
+
+struct Trace {
+	std::vector<std::string> keys;
+	std::vector<Op> ops;
+};
+
+/**
+ *	Reads the trace at `path`. Throws `std::runtime_error` if the file
+ *	cannot be read or a line is not an operation.
+ */
+Trace readTrace(const std::string &path) {
+	std::ifstream file(path);
+	if (!file) {throw std::runtime_error("cannot open " + path);}
+
+	Trace trace;
+	HashTable keyIds;
+	std::string line;
+	for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+		std::string_view rest(line);
+		if (!rest.empty() && rest.back() == '\r') {rest.remove_suffix(1);}
+		if (rest.empty() || rest.front() == '#') {continue;}
+
+		auto nextField = [&rest]() {
+			const size_t start = std::min(rest.find_first_not_of(' '), rest.size());
+			const size_t end = std::min(rest.find(' ', start), rest.size());
+			const std::string_view field = rest.substr(start, end - start);
+			rest.remove_prefix(end);
+			return field;
+		};
+
+		const std::string_view code = nextField(), key = nextField(), value = nextField();
+		const auto type = static_cast<OpType>(std::find(OP_CODES, OP_CODES + OP_TYPES, code.empty() ? '\0' : code.front()) - OP_CODES);
+		const bool takesValue = (type == INSERT || type == UPDATE);
+
+		Op op{0, 0, type};
+		bool valid = (code.size() == 1 && type != OP_TYPES && !key.empty() && nextField().empty() && takesValue != value.empty());
+		if (valid && takesValue) {
+			const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), op.value);
+			valid = (error == std::errc() && end == value.data() + value.size());
+		}
+		if (!valid) {throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": not an operation");}
+
+		const std::optional<size_t> keyId = keyIds.get(key);
+		if (keyId) {op.key = static_cast<uint32_t>(*keyId);}
+		else {
+			op.key = static_cast<uint32_t>(trace.keys.size());
+			keyIds.insert(key, trace.keys.size());
+			trace.keys.emplace_back(key);
+		}
+		trace.ops.push_back(op);
+	}
+	if (file.bad()) {throw std::runtime_error("cannot read " + path);}
+	return trace;
+}
+
+/**
+ *	Latency histogram in the style of HDR Histogram: exact below `2 *
+ *	SUB_BUCKETS` nanoseconds, then `SUB_BUCKETS` buckets per power of two,
+ *	so a percentile is within about 3% of the true latency.
+ */
+class LatencyHistogram {
+	public:
+		static constexpr size_t SUB_BUCKETS = 32;
+
+		LatencyHistogram() : counts(SUB_BUCKETS * 60, 0) {}
+
+		void add(uint64_t nanos) {
+			++this->counts[bucketOf(nanos)];
+			++this->count;
+			this->total += nanos;
+			this->max = std::max(this->max, nanos);
+		}
+
+		void merge(const LatencyHistogram &other) {
+			for (size_t i = 0; i < this->counts.size(); ++i) {this->counts[i] += other.counts[i];}
+			this->count += other.count;
+			this->total += other.total;
+			this->max = std::max(this->max, other.max);
+		}
+
+		/** Returns the lowest latency at or below which `fraction` of the samples lie. */
+		uint64_t percentile(double fraction) const {
+			const uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(this->count)));
+			uint64_t seen = 0;
+			for (size_t i = 0; i < this->counts.size(); ++i) {
+				seen += this->counts[i];
+				if (seen >= rank && seen > 0) {return std::min(lowestOf(i + 1) - 1, this->max);}
+			}
+			return this->max;
+		}
+
+		double mean() const {return (this->count > 0) ? static_cast<double>(this->total) / static_cast<double>(this->count) : 0.0;}
+
+		uint64_t count = 0;
+		uint64_t total = 0;
+		uint64_t max = 0;
+
+	private:
+		std::vector<uint64_t> counts;
+
+		static size_t bucketOf(uint64_t nanos) {
+			if (nanos < 2 * SUB_BUCKETS) {return static_cast<size_t>(nanos);}
+			const size_t shift = static_cast<size_t>(std::bit_width(nanos)) - std::bit_width(2 * SUB_BUCKETS - 1);
+			return SUB_BUCKETS * (shift + 1) + static_cast<size_t>(nanos >> shift) - SUB_BUCKETS;
+		}
+
+		static uint64_t lowestOf(size_t bucket) {
+			if (bucket < 2 * SUB_BUCKETS) {return bucket;}
+			const size_t shift = bucket / SUB_BUCKETS - 1;
+			return static_cast<uint64_t>(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+		}
+};
+
+/** Latencies of one replay thread, per operation type and for resize pauses. */
+struct ReplayResult {
+	LatencyHistogram latencies[OP_TYPES];
+	LatencyHistogram resizes;
+
+	void merge(const ReplayResult &other) {
+		for (size_t type = 0; type < OP_TYPES; ++type) {this->latencies[type].merge(other.latencies[type]);}
+		this->resizes.merge(other.resizes);
+	}
+};
+
+/** Written by every get, so none of them can be optimized away; one per thread, so threads do not share it. */
+thread_local size_t sink = 0;
+
+/**
+ *	How each table runs a trace operation. `run` returns `true` if the
+ *	capacity of the table changed during the operation.
+ */
+template<typename Table>
+struct ReplayTable {
+	static constexpr bool threadSafe = false;
+
+	static bool run(Table &table, const Op &op, const std::string &key) {
+		const size_t capacity = table.capacity();
+		switch (op.type) {
+			case INSERT: table.insert(key, op.value); break;
+			case GET: sink += table.get(key).value_or(0); break;
+			case REMOVE: table.remove(key); break;
+			default:
+				if constexpr (requires {table.fetch_add(key, op.value);}) {table.fetch_add(key, op.value);}
+				else {table[key] += op.value;}
+		}
+		return table.capacity() != capacity;
+	}
+};
+
+template<>
+struct ReplayTable<std::unordered_map<std::string, size_t>> {
+	static constexpr bool threadSafe = false;
+
+	static bool run(std::unordered_map<std::string, size_t> &table, const Op &op, const std::string &key) {
+		const size_t bucketCount = table.bucket_count();
+		switch (op.type) {
+			case INSERT: table.insert_or_assign(key, op.value); break;
+			case GET: {
+				const auto found = table.find(key);
+				sink += (found != table.end()) ? found->second : 0;
+				break;
+			}
+			case REMOVE: table.erase(key); break;
+			default: table[key] += op.value;
+		}
+		return table.bucket_count() != bucketCount;
+	}
+};
+
+/** Runs the operation on the shard of the key, under its lock, like the table's own methods. */
+template<>
+struct ReplayTable<ShardedHashTable> {
+	static constexpr bool threadSafe = true;
+
+	static bool run(ShardedHashTable &table, const Op &op, const std::string &key) {
+		return table.withShard(key, [&](HashTable &shard) {return ReplayTable<HashTable>::run(shard, op, key);});
+	}
+};
+
+/**
+ *	A resize of the concurrent table is seen by every thread whose operation
+ *	overlaps it, so with several threads a pause can be counted more than once.
+ */
+template<>
+struct ReplayTable<ConcurrentHashtable_t<std::string, size_t>> {
+	static constexpr bool threadSafe = true;
+
+	static bool run(ConcurrentHashtable_t<std::string, size_t> &table, const Op &op, const std::string &key) {
+		const size_t capacity = table.capacity();
+		switch (op.type) {
+			case INSERT: table.insert(key, op.value); break;
+			case GET: sink += table.get(key).value_or(0); break;
+			case REMOVE: table.remove(key); break;
+			default: table.fetch_add(key, op.value);
+		}
+		return table.capacity() != capacity;
+	}
+};
+
+double mebibytes(size_t bytes) {
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+/**
+ *	Replays `trace` on a new `Table` with `threads` threads and prints the
+ *	results. Each operation is timed from the end of the previous one, so
+ *	only one clock read is added per operation.
+ */
+template<typename Table>
+int replay(const char *name, const Trace &trace, size_t threads) {
+	if (threads > 1 && !ReplayTable<Table>::threadSafe) {
+		std::fprintf(stderr, "%s cannot be replayed by more than one thread\n", name);
+		return 1;
+	}
+
+	const size_t residentBefore = peakResidentBytes();
+	Table table;
+	std::vector<ReplayResult> results(threads);
+	std::latch ready(static_cast<std::ptrdiff_t>(threads + 1));
+
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t]() {
+			ReplayResult &result = results[t];
+			ready.arrive_and_wait();
+			auto last = std::chrono::steady_clock::now();
+			for (size_t i = t; i < trace.ops.size(); i += threads) {
+				const Op &op = trace.ops[i];
+				const bool resized = ReplayTable<Table>::run(table, op, trace.keys[op.key]);
+				const auto now = std::chrono::steady_clock::now();
+				const uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count());
+				result.latencies[op.type].add(nanos);
+				if (resized) {result.resizes.add(nanos);}
+				last = now;
+			}
+		});
+	}
+	const auto start = std::chrono::steady_clock::now();
+	ready.arrive_and_wait();
+	for (std::thread &worker : workers) {worker.join();}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (size_t t = 1; t < threads; ++t) {results[0].merge(results[t]);}
+	const ReplayResult &result = results[0];
+
+	std::printf("replay\n");
+	std::printf("  table           %s, %zu thread%s\n", name, threads, (threads == 1) ? "" : "s");
+	std::printf("  operations      %zu on %zu distinct keys\n", trace.ops.size(), trace.keys.size());
+	std::printf("  time            %.3f s\n", seconds);
+	std::printf("  throughput      %.0f ops/s\n", static_cast<double>(trace.ops.size()) / seconds);
+	std::printf("  final size      %zu\n", table.size());
+
+	std::printf("\nlatency (ns) %12s %9s %9s %9s %9s %9s %9s %11s\n", "count", "mean", "p50", "p90", "p99", "p99.9", "p99.99", "max");
+	for (size_t type = 0; type < OP_TYPES; ++type) {
+		const LatencyHistogram &latencies = result.latencies[type];
+		if (latencies.count == 0) {continue;}
+		std::printf("  %-10s %12llu %9.0f %9llu %9llu %9llu %9llu %9llu %11llu\n", OP_NAMES[type],
+			static_cast<unsigned long long>(latencies.count), latencies.mean(),
+			static_cast<unsigned long long>(latencies.percentile(0.5)), static_cast<unsigned long long>(latencies.percentile(0.9)),
+			static_cast<unsigned long long>(latencies.percentile(0.99)), static_cast<unsigned long long>(latencies.percentile(0.999)),
+			static_cast<unsigned long long>(latencies.percentile(0.9999)), static_cast<unsigned long long>(latencies.max));
+	}
+
+	std::printf("\nresize pauses\n");
+	std::printf("  count           %llu\n", static_cast<unsigned long long>(result.resizes.count));
+	std::printf("  total           %.3f ms\n", static_cast<double>(result.resizes.total) / 1e6);
+	std::printf("  longest         %.3f ms\n", static_cast<double>(result.resizes.max) / 1e6);
+
+	std::printf("\nmemory\n");
+	std::printf("  peak resident   %.1f MiB (%.1f MiB before the replay)\n", mebibytes(peakResidentBytes()), mebibytes(residentBefore));
+	return 0;
+}
+
+/** Writes a trace of `operations` operations from `model` to standard output. */
+int generate(const std::string &model, size_t operations, size_t keyCount, uint64_t seed) {
+	if (model != "uniform" && model != "zipf" && model != "hotspot" && model != "churn") {
+		std::fprintf(stderr, "unknown model %s, expected uniform, zipf, hotspot or churn\n", model.c_str());
+		return 1;
+	}
+	std::mt19937_64 random(seed);
+
+	// Key ids are scrambled by an odd multiplier, which keeps them distinct, so hot keys do not look alike.
+	auto printOp = [](OpType type, size_t keyId, uint64_t value) {
+		std::printf("%c key:%llu", OP_CODES[type], static_cast<unsigned long long>(keyId * 0x9E3779B97F4A7C15ULL));
+		if (type == INSERT || type == UPDATE) {std::printf(" %llu", static_cast<unsigned long long>(value));}
+		std::printf("\n");
+	};
+
+	std::printf("# %s model, %zu operations, %zu keys, seed %llu\n", model.c_str(), operations, keyCount, static_cast<unsigned long long>(seed));
+
+	if (model == "churn") {
+		for (size_t step = 0, written = 0; written < operations; ++step) {
+			const OpType types[] = {INSERT, REMOVE, GET, GET};
+			for (const OpType type : types) {
+				if (written == operations) {break;}
+				if (type == REMOVE && step < keyCount) {continue;}
+				const size_t live = std::min(step + 1, keyCount);
+				const size_t keyId = (type == INSERT) ? step : (type == REMOVE) ? step - keyCount : step - random() % live;
+				printOp(type, keyId, random() % 1000);
+				++written;
+			}
+		}
+		return 0;
+	}
+
+	std::vector<size_t> keyIds(operations);
+	if (model == "zipf") {keyIds = zipfRanks(random, keyCount, operations);}
+	else if (model == "hotspot") {
+		const size_t hotKeys = std::max<size_t>(1, keyCount / 10);
+		for (size_t &keyId : keyIds) {keyId = (random() % 10 < 9) ? random() % hotKeys : random() % keyCount;}
+	} else {
+		for (size_t &keyId : keyIds) {keyId = random() % keyCount;}
+	}
+
+	for (const size_t keyId : keyIds) {
+		const uint64_t draw = random() % 100;
+		const OpType type = (draw < 60) ? GET : (draw < 80) ? UPDATE : (draw < 95) ? INSERT : REMOVE;
+		printOp(type, keyId, (type == UPDATE) ? 1 : random() % 1000);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	const std::string command = (argc > 1) ? argv[1] : "";
+
+	if (command == "generate" && argc > 3) {
+		const size_t operations = static_cast<size_t>(std::atoll(argv[3]));
+		const size_t keyCount = (argc > 4) ? static_cast<size_t>(std::atoll(argv[4])) : std::max<size_t>(1, operations / 10);
+		const uint64_t seed = (argc > 5) ? static_cast<uint64_t>(std::atoll(argv[5])) : 42;
+		return generate(argv[2], operations, std::max<size_t>(1, keyCount), seed);
+	}
+
+	if (command != "replay" || argc < 3) {
+		std::fprintf(stderr, "usage: %s replay <trace> [table] [threads]\n", argv[0]);
+		std::fprintf(stderr, "       %s generate <uniform|zipf|hotspot|churn> <operations> [keys] [seed]\n", argv[0]);
+		return 1;
+	}
+
+	const std::string table = (argc > 3) ? argv[3] : "HashTable";
+	const size_t threads = (argc > 4) ? std::max<size_t>(1, static_cast<size_t>(std::atoll(argv[4]))) : 1;
+
+	Trace trace;
+	try {
+		trace = readTrace(argv[2]);
+	} catch (const std::exception &error) {
+		std::fprintf(stderr, "%s\n", error.what());
+		return 1;
+	}
+
+	if (table == "HashTable") {return replay<HashTable>("HashTable", trace, threads);}
+	if (table == "FlatHashtable_t") {return replay<FlatHashtable_t<std::string, size_t>>("FlatHashtable_t", trace, threads);}
+	if (table == "IncrementalHashtable_t") {return replay<IncrementalHashtable_t<std::string, size_t>>("IncrementalHashtable_t", trace, threads);}
+	if (table == "std::unordered_map") {return replay<std::unordered_map<std::string, size_t>>("std::unordered_map", trace, threads);}
+	if (table == "ShardedHashTable") {return replay<ShardedHashTable>("ShardedHashTable", trace, threads);}
+	if (table == "ConcurrentHashtable_t") {return replay<ConcurrentHashtable_t<std::string, size_t>>("ConcurrentHashtable_t", trace, threads);}
+
+	std::fprintf(stderr, "unknown table %s\n", table.c_str());
+	return 1;
+}
@@ -0,0 +1,65 @@
+/**
+ *	HashTableShardBench.cpp
+ *
+ *	Counter workload on `ShardedHashTable`: every thread increments random
+ *	counters out of a shared key set. Sweeps the thread count against the
+ *	shard count; one shard is the same as one global mutex around a
+ *	`HashTable`.
+ *
+ *	Usage: `HashTableShardBench [max threads] [increments per thread]`,
+ *	defaults are the hardware concurrency and 1000000.
+ */
+
+#include "HashTableSharded.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** Runs the counter workload and returns millions of increments per second. */
+double measure(size_t shardCount, size_t threads, size_t increments, const std::vector<std::string> &keys) {
+	ShardedHashTable table(shardCount);
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t]() {
+			std::mt19937_64 random(t);
+			for (size_t i = 0; i < increments; ++i) {
+				const std::string &key = keys[random() % keys.size()];
+				table.fetch_add(key, 1);
+			}
+		});
+	}
+	for (std::thread &worker : workers) {worker.join();}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return static_cast<double>(threads * increments) / seconds / 1e6;
+}
+
+int main(int argc, char **argv) {
+	const size_t maxThreads = (argc > 1) ? static_cast<size_t>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	const size_t increments = (argc > 2) ? static_cast<size_t>(std::atoll(argv[2])) : 1000000;
+	const size_t shardCounts[] = {1, 4, 16, 64};
+
+	std::vector<std::string> keys(100000);
+	for (size_t i = 0; i < keys.size(); ++i) {keys[i] = "counter:" + std::to_string(i);}
+
+	std::printf("%zu counters, %zu increments per thread, M increments/s\n\n", keys.size(), increments);
+	std::printf("%8s", "threads");
+	for (const size_t shardCount : shardCounts) {std::printf(" %9zu sh", shardCount);}
+	std::printf("\n");
+
+	for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+		std::printf("%8zu", threads);
+		for (const size_t shardCount : shardCounts) {std::printf(" %12.2f", measure(shardCount, threads, increments, keys));}
+		std::printf("\n");
+	}
+
+	return 0;
+}
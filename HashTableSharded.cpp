@@ -0,0 +1,127 @@
+/**
+ *	HashTableSharded.cpp
+ */
+
+#include "HashTableSharded.h"
+#include <bit>
+
+/**
+ *	The shard count is rounded up to a power of two, so routing takes the
+ *	top `shardBits` bits of the hash. Every shard starts with `initCapacity`
+ *	buckets and hashes keys with the routing key hash, so a hash code
+ *	computed for routing is valid in the shard; with a seeded
+ *	`HashTable::Hash`, every shard shares the seed of the sharded table.
+ */
+ShardedHashTable::ShardedHashTable(size_t shardCount, size_t initCapacity) {
+	shardCount = std::bit_ceil(shardCount > 0 ? shardCount : 1);
+	this->shardBits = static_cast<size_t>(std::countr_zero(shardCount));
+	this->shards = std::make_unique<Shard[]>(shardCount);
+	for (size_t shardIndex = 0; shardIndex < shardCount; ++shardIndex) {
+		this->shards[shardIndex].table = HashTable(initCapacity, this->hasher, std::pmr::get_default_resource());
+	}
+}
+
+/**
+ *	Returns the shard of the key whose hash code is `keyHash`. A single
+ *	shard needs no routing, and shifting a 64-bit hash by 64 would be
+ *	undefined.
+ */
+ShardedHashTable::Shard & ShardedHashTable::shardFor(size_t keyHash) const {
+	if (this->shardBits == 0) {return this->shards[0];}
+	const uint64_t hash = mixHash(keyHash);
+	return this->shards[static_cast<size_t>(hash >> (64 - this->shardBits))];
+}
+
+/**
+ *	@brief Inserts a new key-value pair into the shard of `key`.
+ *
+ *	Returns `true` if a unique key is inserted, `false` if the key was
+ *	already present, in which case its value is overwritten.
+ */
+bool ShardedHashTable::insert(std::string_view key, const size_t &value) {
+	const size_t keyHash = this->hasher(key);
+	Shard &shard = this->shardFor(keyHash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.table.insert(key, keyHash, value);
+}
+
+/** Removes `key` from its shard, returning `true` if it was there. */
+bool ShardedHashTable::remove(std::string_view key) {
+	const size_t keyHash = this->hasher(key);
+	Shard &shard = this->shardFor(keyHash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.table.remove(key, keyHash);
+}
+
+/** Returns `true` if and only if `key` exists in its shard. */
+bool ShardedHashTable::contains(std::string_view key) const {
+	const size_t keyHash = this->hasher(key);
+	const Shard &shard = this->shardFor(keyHash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.table.contains(key, keyHash);
+}
+
+/** Returns the value of `key` in its shard, or `nullopt`. */
+std::optional<size_t> ShardedHashTable::get(std::string_view key) const {
+	const size_t keyHash = this->hasher(key);
+	const Shard &shard = this->shardFor(keyHash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.table.get(key, keyHash);
+}
+
+/**
+ *	Adds `delta` to the value of `key` in its shard, inserting it with value
+ *	`delta` if it is missing, and returns the previous value (`0` if new).
+ */
+size_t ShardedHashTable::fetch_add(std::string_view key, size_t delta) {
+	const size_t keyHash = this->hasher(key);
+	Shard &shard = this->shardFor(keyHash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.table.fetch_add(key, keyHash, delta);
+}
+
+/**
+ *	Returns the keys of every shard. Shards are locked one at a time, so
+ *	the result is not a snapshot of the whole table while writers run.
+ */
+std::vector<std::string> ShardedHashTable::keys() const {
+	std::vector<std::string> keyList;
+	for (size_t shardIndex = 0; shardIndex < this->shardCount(); ++shardIndex) {
+		const Shard &shard = this->shards[shardIndex];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for (std::string &key : shard.table.keys()) {keyList.push_back(std::move(key));}
+	}
+	return keyList;
+}
+
+/** Returns the load factor over all shards, which is `size / capacity`. */
+double ShardedHashTable::alpha() const {
+	return static_cast<double>(this->size()) / static_cast<double>(this->capacity());
+}
+
+/** Returns the number of buckets over all shards. */
+size_t ShardedHashTable::capacity() const {
+	size_t buckets = 0;
+	for (size_t shardIndex = 0; shardIndex < this->shardCount(); ++shardIndex) {
+		const Shard &shard = this->shards[shardIndex];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		buckets += shard.table.capacity();
+	}
+	return buckets;
+}
+
+/** Returns the number of key-value pairs over all shards. */
+size_t ShardedHashTable::size() const {
+	size_t entries = 0;
+	for (size_t shardIndex = 0; shardIndex < this->shardCount(); ++shardIndex) {
+		const Shard &shard = this->shards[shardIndex];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		entries += shard.table.size();
+	}
+	return entries;
+}
+
+/** Returns the number of shards, a power of two. */
+size_t ShardedHashTable::shardCount() const {
+	return size_t{1} << this->shardBits;
+}
@@ -0,0 +1,80 @@
+/**
+ *	HashTableSharded.h
+ */
+
+#ifndef HASHTABLESHARDED_H
+#define HASHTABLESHARDED_H
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "HashTable.h"
+
+/**
+ *	Thread-safe table split into independent `HashTable` shards, each behind
+ *	its own mutex. A key is hashed once: it is routed to a shard by the high
+ *	bits of its mixed hash, and the shard probes with the same hash code and
+ *	indexes with the low bits, so both stay uniform. Each shard grows on its
+ *	own, and a resize only holds the lock of the shard being resized.
+ */
+class ShardedHashTable {
+	public:
+		static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+		ShardedHashTable(size_t shardCount = DEFAULT_SHARD_COUNT, size_t initCapacity = HashTable::DEFAULT_INITIAL_CAPACITY);
+
+		bool insert(std::string_view key, const size_t &value);
+		bool remove(std::string_view key);
+		bool contains(std::string_view key) const;
+
+		std::optional<size_t> get(std::string_view key) const;
+
+		size_t fetch_add(std::string_view key, size_t delta);
+
+		/** `HashTable::upsert` on the shard of `key`, under its lock. */
+		template<typename Fn>
+		bool upsert(std::string_view key, Fn &&update) {
+			const size_t keyHash = this->hasher(key);
+			Shard &shard = this->shardFor(keyHash);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			return shard.table.upsert(key, keyHash, std::forward<Fn>(update));
+		}
+
+		/**
+		 *	Runs `fn(shard)` on the shard `key` routes to while holding its lock,
+		 *	so several calls on that shard happen as one step.
+		 */
+		template<typename Fn>
+		decltype(auto) withShard(std::string_view key, Fn &&fn) {
+			Shard &shard = this->shardFor(this->hasher(key));
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			return fn(shard.table);
+		}
+
+		std::vector<std::string> keys() const;
+
+		double alpha() const;
+
+		size_t capacity() const;
+		size_t size() const;
+		size_t shardCount() const;
+
+	private:
+		/** Padded to a cache line, so locking one shard never touches another shard's line. */
+		struct alignas(64) Shard {
+			mutable std::mutex mutex;
+			HashTable table;
+		};
+
+		std::unique_ptr<Shard[]> shards;
+		size_t shardBits;
+		HashTable::Hash hasher;
+
+		Shard & shardFor(size_t keyHash) const;
+};
+
+#endif
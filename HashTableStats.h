@@ -0,0 +1,111 @@
+/**
+ *	HashTableStats.h
+ *
+ *	Occupancy, probe-length and memory summary returned by
+ *	`HashTable::stats()`.
+ *
+ *	Everything except the resize counters is measured by scanning the table
+ *	when `stats()` is called, so it costs nothing in between. The resize
+ *	counters are kept by `HashTable` itself and only when it is compiled with
+ *	`HASHTABLE_STATS` defined; otherwise they stay `0`.
+ */
+
+#ifndef HASHTABLESTATS_H
+#define HASHTABLESTATS_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#ifdef HASHTABLE_STATS
+constexpr bool HASHTABLE_STATS_ENABLED = true;
+#else
+constexpr bool HASHTABLE_STATS_ENABLED = false;
+#endif
+
+/** Distribution of a length, e.g. the probes of a lookup, as a histogram. */
+struct LengthStats {
+
+	/** `histogram[n]` is how many samples had length `n`. */
+	std::vector<size_t> histogram;
+
+	size_t samples = 0;
+	double mean = 0.0;
+	size_t max = 0;
+	size_t p99 = 0;
+
+	/** Adds one sample of length `length`. */
+	void add(size_t length) {
+		if (length >= this->histogram.size()) {this->histogram.resize(length + 1, 0);}
+		++this->histogram[length];
+	}
+
+	/** Computes `samples`, `mean`, `max` and `p99` from the histogram. */
+	void summarize() {
+		size_t total = 0;
+		this->samples = 0;
+		this->max = 0;
+		for (size_t length = 0; length < this->histogram.size(); ++length) {
+			this->samples += this->histogram[length];
+			total += length * this->histogram[length];
+			if (this->histogram[length] > 0) {this->max = length;}
+		}
+		this->mean = (this->samples > 0) ? static_cast<double>(total) / static_cast<double>(this->samples) : 0.0;
+
+		// The smallest length that at least 99% of the samples do not exceed.
+		size_t seen = 0;
+		for (size_t length = 0; length < this->histogram.size(); ++length) {
+			seen += this->histogram[length];
+			if (100 * seen >= 99 * this->samples) {this->p99 = length; break;}
+		}
+	}
+};
+
+struct HashTableStats {
+	size_t capacity = 0;
+	size_t size = 0;
+	size_t tombstones = 0;
+	size_t empty = 0;
+	double loadFactor = 0.0;
+
+	/** Probes of a successful lookup, over every key in the table. */
+	LengthStats hitProbes;
+
+	/** Probes of an unsuccessful lookup, over `MISS_SAMPLES` random hash codes. */
+	LengthStats missProbes;
+
+	/** Lengths of the runs of consecutive `NORMAL` or `EAR` buckets. */
+	LengthStats clusters;
+
+	/** Only counted with `HASHTABLE_STATS`. */
+	size_t resizes = 0;
+	double resizeSeconds = 0.0;
+
+	size_t bucketBytes = 0;
+	size_t keyArenaBytes = 0;
+	size_t keyArenaUsedBytes = 0;
+	size_t probingBytes = 0;
+
+	static constexpr size_t MISS_SAMPLES = 1 << 16;
+
+	size_t totalBytes() const {return this->bucketBytes + this->keyArenaBytes + this->probingBytes;}
+
+	/** Prints a summary, one section per line, without the histograms. */
+	friend std::ostream & operator<<(std::ostream &os, const HashTableStats &stats) {
+		auto printLengths = [&os](const char *name, const LengthStats &lengths) {
+			os << name << ": mean " << lengths.mean << ", p99 " << lengths.p99 << ", max " << lengths.max << " (" << lengths.samples << " samples)\n";
+		};
+
+		os << "buckets: " << stats.capacity << " (" << stats.size << " live, " << stats.tombstones << " tombstones, "
+			<< stats.empty << " empty), load factor " << stats.loadFactor << "\n";
+		printLengths("probes per hit", stats.hitProbes);
+		printLengths("probes per miss", stats.missProbes);
+		printLengths("cluster length", stats.clusters);
+		if (HASHTABLE_STATS_ENABLED) {os << "resizes: " << stats.resizes << " in " << stats.resizeSeconds << " s\n";}
+		os << "bytes: " << stats.totalBytes() << " (buckets " << stats.bucketBytes << ", key arena " << stats.keyArenaBytes
+			<< " with " << stats.keyArenaUsedBytes << " used, probing " << stats.probingBytes << ")\n";
+		return os;
+	}
+};
+
+#endif
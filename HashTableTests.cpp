@@ -13,17 +13,19 @@
 
 #define RUN_TESTS
 // #define USE_IMPL
+// #define USE_FLAT
+// #define USE_INCREMENTAL
 // #define GRADING	/* Uncomment for grading mode file output. */
 
 #ifdef RUN_TESTS
 
-#include "HashTable.h"
-
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include <type_traits>
 #include <optional>
+#include <stdexcept>
 #include <string>
 
 using namespace std;
@@ -46,10 +48,27 @@ using value_type = size_t;		// or std::string, int, double
 #ifdef USE_IMPL
 #include "HashTableImpl.h"
 using HashTable = Hashtable_t<key_type, value_type>;
+#elif defined(USE_FLAT)
+#include "HashTableFlat.h"
+using HashTable = FlatHashtable_t<key_type, value_type>;
+#elif defined(USE_INCREMENTAL)
+#include "HashTableIncremental.h"
+using HashTable = IncrementalHashtable_t<key_type, value_type>;
 #else
 #include "HashTable.h" // Must match key_type/value_type of the tested HashTable
+#include "HashTableLoader.h"
+#include "HashTableMapped.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #endif
 
+// The hasher tests build tables with an explicit `Hash`, whatever is tested above.
+#include "HashTableFlat.h"
+#include "HashTableHash.h"
+#include "HashTableImpl.h"
+#include "HashTableIncremental.h"
+
 //	-----------------------------------------------------------------------------
 /**	Helpers: `make_key` / `make_value`
  *	Convert an integral loop index into a key/value for current `key_type/value_type`.
@@ -77,6 +96,25 @@ requires std::is_integral_v<IndexType> {
 	}
 }
 
+//	-----------------------------------------------------------------------------
+/**	Stub hasher: `CollidingHash`
+ *	Gives every key the same hash code, so tables that compare stored hash
+ *	codes before keys must still tell the keys apart by their bytes.
+ */
+//	-----------------------------------------------------------------------------
+struct CollidingHash {
+	using is_transparent = void;
+
+	static constexpr bool seeded = false;
+
+	CollidingHash() = default;
+	explicit CollidingHash(uint64_t) {}
+
+	size_t operator()(std::string_view) const {return 42;}
+
+	uint64_t seed() const {return 0;}
+};
+
 //	-----------------------------------------------------------------------------
 /**
  *	Output routing and test toggles.
@@ -111,10 +149,52 @@ const string evalName{""};
 #define HT_GET_AFTER_REMOVE
 #define HT_BRACKET_OP_GET
 #define HT_BRACKET_OP_SET
+#define HT_BRACKET_OP_INSERT
 #define HT_KEYS
 #define HT_ALPHA
 #define HT_CAPACITY
 #define HT_SIZE
+#define HT_SIPHASH_VECTORS
+#define HT_SIPHASH_SEEDS
+#define HT_HASH_VECTORS
+#define HT_EQUAL_HASHES
+
+/**
+ *	Tests of features only `HashTable` has, skipped for the templated tables.
+ */
+#if !defined(USE_IMPL) && !defined(USE_FLAT) && !defined(USE_INCREMENTAL)
+#define HT_ARENA_CHURN
+#define HT_INSERT_RANGE
+#define HT_MAPPED_ROUND_TRIP
+#define HT_MAPPED_BAD_CHECKSUM
+#define HT_MAPPED_TRUNCATED
+#define HT_LOADER
+#define HT_STATS
+#endif
+
+/**
+ *	Tests of `upsert` and `fetch_add`, which `HashTable` and `Hashtable_t` have.
+ */
+#if !defined(USE_FLAT) && !defined(USE_INCREMENTAL)
+#define HT_UPSERT_RESIZE
+#endif
+
+/**
+ *	Tests of `reserve`, `rehash`, `max_load_factor` and `tombstoneCount`,
+ *	which every table but `IncrementalHashtable_t` has.
+ */
+#if !defined(USE_INCREMENTAL)
+#define HT_LOAD_FACTOR
+#define HT_TOMBSTONE_CHURN
+#endif
+
+/**
+ *	Tests of `get_many` and `contains_many`, which `HashTable` and
+ *	`FlatHashtable_t` have.
+ */
+#if !defined(USE_IMPL) && !defined(USE_INCREMENTAL)
+#define HT_BATCHED_LOOKUP
+#endif
 
 //	-----------------------------------------------------------------------------
 /**
@@ -633,6 +713,38 @@ int main(int, char**) {
 	OUTSTREAM << "*** DID NOT TEST OPERATOR[] SET ***" << endl << endl;
 #endif // HT_BRACKET_OP_SET
 
+	/**	=====================================================================
+	 *	operator[] INSERT
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing operator[] (insert on missing key)" << endl;
+	OUTSTREAM << "------------------------------------------" << endl << endl;
+#ifdef HT_BRACKET_OP_INSERT
+	try {
+		HashTable ht1;
+
+		OUTSTREAM << "Inserting " << MAXHASH << " entries..." << endl;
+		for (size_t i = 1; i <= MAXHASH; i++) {
+			ht1.insert(make_key<key_type>(i), make_value<value_type>(i));
+		}
+
+		auto k = make_key<key_type>(MAXHASH + 1);
+		OUTSTREAM << "Reading ht1[" << k << "], a key not in the table..." << endl;
+		value_type v = ht1[k];
+		bool ok = (v == value_type{}) && (ht1.size() == MAXHASH + 1) && ht1.contains(k);
+
+		OUTSTREAM << "Writing ht1[" << k << "] = " << make_value<value_type>(42) << " and reading it back..." << endl;
+		ht1[k] = make_value<value_type>(42);
+		ok &= (ht1.get(k) == std::optional<value_type>(make_value<value_type>(42))) && (ht1.size() == MAXHASH + 1);
+		OUTSTREAM << (ok ? "SUCCESS: operator[] inserted the missing key with a value-initialized value."
+				: "FAILURE: operator[] did not insert the missing key as expected.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST OPERATOR[] INSERT ***" << endl << endl;
+#endif // HT_BRACKET_OP_INSERT
+
 	/**	=====================================================================
 	 *	KEYS
 	 *	=====================================================================	*/
@@ -764,6 +876,718 @@ int main(int, char**) {
 	OUTSTREAM << "*** DID NOT TEST SIZE ***" << endl << endl;
 #endif // HT_SIZE
 
+	/**	=====================================================================
+	 *	ARENA CHURN
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing HashTable::arenaBytes() under insert/remove churn" << endl;
+	OUTSTREAM << "---------------------------------------------------------" << endl << endl;
+#ifdef HT_ARENA_CHURN
+	try {
+		HashTable ht1;
+		constexpr size_t LIVE = 100;
+		constexpr size_t CYCLES = 200000;
+		auto longKey = [](size_t i) {return "session:" + std::string(32, '-') + std::to_string(i);};
+
+		OUTSTREAM << "Inserting " << LIVE << " keys too long to be stored inline..." << endl;
+		for (size_t i = 0; i < LIVE; i++) {
+			ht1.insert(longKey(i), i);
+		}
+
+		OUTSTREAM << "Replacing the oldest key with a new one " << CYCLES << " times..." << endl;
+		size_t peak = 0;
+		for (size_t i = LIVE; i < LIVE + CYCLES; i++) {
+			ht1.remove(longKey(i - LIVE));
+			ht1.insert(longKey(i), i);
+			peak = std::max(peak, ht1.arenaBytes());
+		}
+
+		bool ok = (ht1.size() == LIVE);
+		for (size_t i = CYCLES; i < LIVE + CYCLES; i++) {
+			ok &= (ht1.get(longKey(i)) == std::optional<size_t>(i));
+		}
+		OUTSTREAM << "  size() = " << ht1.size() << ", peak arenaBytes() = " << peak << endl;
+		ok &= (peak <= 4 * StringArena::CHUNK_SIZE);
+		OUTSTREAM << (ok ? "SUCCESS: arena stayed bounded and every live key kept its value."
+				: "FAILURE: arena kept growing or live keys were lost.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST ARENA CHURN ***" << endl << endl;
+#endif // HT_ARENA_CHURN
+
+	/**	=====================================================================
+	 *	INSERT_RANGE (parallel path)
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing HashTable::insert_range() on several threads" << endl;
+	OUTSTREAM << "----------------------------------------------------" << endl << endl;
+#ifdef HT_INSERT_RANGE
+	try {
+		const size_t pairCount = HashTable::PARALLEL_INSERT_THRESHOLD + 20000;
+		std::vector<std::string> keyStore(pairCount);
+		std::vector<std::pair<std::string_view, size_t>> entries(pairCount);
+		for (size_t i = 0; i < pairCount; i++) {
+			// Every fifth pair repeats an earlier key, and every third new key is too long to be stored inline.
+			keyStore[i] = (i % 5 == 4) ? keyStore[(i * 7919) % i] : ((i % 3 == 0) ? "a-long-bulk-loaded-key:" : "k") + std::to_string(i);
+			entries[i] = {keyStore[i], i};
+		}
+
+		OUTSTREAM << "Preloading both tables with 1000 of the keys..." << endl;
+		HashTable ht1;
+		HashTable reference;
+		for (size_t i = 0; i < 1000; i++) {
+			ht1.insert(keyStore[i * 3], 0);
+			reference.insert(keyStore[i * 3], 0);
+		}
+
+		// A high max load factor makes clusters run across the bucket ranges, so many probes are deferred.
+		ht1.max_load_factor(0.9);
+		reference.max_load_factor(0.9);
+
+		OUTSTREAM << "Inserting " << pairCount << " pairs with insert_range() on 4 threads, and one by one with insert()..." << endl;
+		std::vector<char> expected(pairCount);
+		for (size_t i = 0; i < pairCount; i++) {
+			expected[i] = reference.insert(entries[i].first, entries[i].second);
+		}
+		std::unique_ptr<bool[]> inserted(new bool[pairCount]);
+		const size_t newKeys = ht1.insert_range(entries, std::span<bool>(inserted.get(), pairCount), 4);
+
+		bool ok = (ht1.size() == reference.size());
+		size_t expectedNewKeys = 0;
+		for (size_t i = 0; i < pairCount; i++) {
+			ok &= (inserted[i] == static_cast<bool>(expected[i]));
+			ok &= (ht1.get(keyStore[i]) == reference.get(keyStore[i]));
+			expectedNewKeys += expected[i];
+		}
+		ok &= (newKeys == expectedNewKeys);
+		OUTSTREAM << "  size() = " << ht1.size() << " (expected " << reference.size() << "), new keys = " << newKeys
+				<< " (expected " << expectedNewKeys << ")" << endl;
+		OUTSTREAM << (ok ? "SUCCESS: insert_range() matched sequential insert() in flags, values and size."
+				: "FAILURE: insert_range() differed from sequential insert().")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST INSERT_RANGE ***" << endl << endl;
+#endif // HT_INSERT_RANGE
+
+#if defined(HT_MAPPED_ROUND_TRIP) || defined(HT_MAPPED_BAD_CHECKSUM) || defined(HT_MAPPED_TRUNCATED)
+	const std::string imagePath = (std::filesystem::temp_directory_path() / "HashTableTests.image").string();
+	auto readImage = [&imagePath]() {
+		std::ifstream in(imagePath, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	};
+	auto writeImage = [&imagePath](const std::vector<char> &bytes) {
+		std::ofstream out(imagePath, std::ios::binary | std::ios::trunc);
+		out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	};
+	auto saveSample = [&imagePath]() {
+		HashTable ht1;
+		for (size_t i = 0; i < 100; i++) {
+			ht1.insert((i % 2 == 0 ? "image-key-long-enough-for-the-arena:" : "k") + std::to_string(i), i);
+		}
+		ht1.remove("k1");
+		ht1.save(imagePath);
+		return ht1;
+	};
+#endif
+
+	/**	=====================================================================
+	 *	SAVE / OPEN_MAPPED ROUND TRIP
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing HashTable::save() and open_mapped() round trip" << endl;
+	OUTSTREAM << "------------------------------------------------------" << endl << endl;
+#ifdef HT_MAPPED_ROUND_TRIP
+	try {
+		OUTSTREAM << "Saving a table of 99 keys, half of them long, after one removal..." << endl;
+		const HashTable ht1 = saveSample();
+		MappedHashTable mapped = HashTable::open_mapped(imagePath);
+
+		bool ok = mapped.verify() && mapped.size() == ht1.size() && mapped.capacity() == ht1.capacity();
+		for (size_t i = 0; i < 100; i++) {
+			const std::string k = (i % 2 == 0 ? "image-key-long-enough-for-the-arena:" : "k") + std::to_string(i);
+			ok &= (mapped.get(k) == ht1.get(k)) && (mapped.contains(k) == ht1.contains(k));
+		}
+		ok &= !mapped.contains("missing");
+		auto savedKeys = ht1.keys();
+		auto mappedKeys = mapped.keys();
+		std::sort(savedKeys.begin(), savedKeys.end());
+		std::sort(mappedKeys.begin(), mappedKeys.end());
+		ok &= (savedKeys == mappedKeys);
+		OUTSTREAM << "  mapped size() = " << mapped.size() << ", capacity() = " << mapped.capacity() << endl;
+		OUTSTREAM << (ok ? "SUCCESS: the mapped image answered every lookup like the saved table."
+				: "FAILURE: the mapped image differs from the saved table.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST MAPPED ROUND TRIP ***" << endl << endl;
+#endif // HT_MAPPED_ROUND_TRIP
+
+	/**	=====================================================================
+	 *	OPEN_MAPPED WITH A BAD CHECKSUM
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing open_mapped() and verify() on corrupted images" << endl;
+	OUTSTREAM << "------------------------------------------------------" << endl << endl;
+#ifdef HT_MAPPED_BAD_CHECKSUM
+	try {
+		saveSample();
+		const std::vector<char> image = readImage();
+		bool ok = true;
+
+		OUTSTREAM << "Flipping a byte of the header size field..." << endl;
+		std::vector<char> corrupt = image;
+		corrupt[offsetof(HashTableImage::Header, size)] ^= 1;
+		writeImage(corrupt);
+		try {
+			HashTable::open_mapped(imagePath);
+			ok = false;
+		} catch (std::runtime_error& e) {
+			OUTSTREAM << "  open_mapped() threw: " << e.what() << endl;
+		}
+
+		OUTSTREAM << "Pointing the key of every normal bucket record past the key bytes..." << endl;
+		corrupt = image;
+		for (size_t offset = sizeof(HashTableImage::Header); offset + sizeof(HashTableImage::Bucket) <= corrupt.size(); offset += sizeof(HashTableImage::Bucket)) {
+			HashTableImage::Bucket record;
+			std::memcpy(&record, corrupt.data() + offset, sizeof(record));
+			if (record.state != HashTableImage::NORMAL) {continue;}
+			record.keyOffset = uint64_t{1} << 40;
+			std::memcpy(corrupt.data() + offset, &record, sizeof(record));
+		}
+		writeImage(corrupt);
+		MappedHashTable mapped = HashTable::open_mapped(imagePath);
+		const bool verified = mapped.verify();
+		const size_t keyCount = mapped.keys().size();
+		const bool found = mapped.contains("k3");
+		OUTSTREAM << "  verify() -> " << (verified ? "true" : "false") << ", keys() returned " << keyCount
+				<< " keys, contains(k3) -> " << (found ? "true" : "false") << endl;
+		ok &= !verified && keyCount == 0 && !found;
+
+		OUTSTREAM << (ok ? "SUCCESS: corrupted images were refused or read within bounds."
+				: "FAILURE: a corrupted image was accepted or read out of bounds.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST MAPPED BAD CHECKSUM ***" << endl << endl;
+#endif // HT_MAPPED_BAD_CHECKSUM
+
+	/**	=====================================================================
+	 *	OPEN_MAPPED ON A TRUNCATED FILE
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing open_mapped() on truncated images" << endl;
+	OUTSTREAM << "-----------------------------------------" << endl << endl;
+#ifdef HT_MAPPED_TRUNCATED
+	try {
+		saveSample();
+		const std::vector<char> image = readImage();
+		bool ok = true;
+
+		for (const size_t length : {size_t{0}, sizeof(HashTableImage::Header) - 1, sizeof(HashTableImage::Header), image.size() - 1}) {
+			writeImage(std::vector<char>(image.begin(), image.begin() + static_cast<std::ptrdiff_t>(length)));
+			try {
+				HashTable::open_mapped(imagePath);
+				OUTSTREAM << "  open_mapped() accepted " << length << " of " << image.size() << " bytes" << endl;
+				ok = false;
+			} catch (std::runtime_error& e) {
+				OUTSTREAM << "  " << length << " of " << image.size() << " bytes: " << e.what() << endl;
+			}
+		}
+		std::filesystem::remove(imagePath);
+
+		OUTSTREAM << (ok ? "SUCCESS: every truncated image was refused."
+				: "FAILURE: a truncated image was accepted.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST MAPPED TRUNCATED ***" << endl << endl;
+#endif // HT_MAPPED_TRUNCATED
+
+	/**	=====================================================================
+	 *	SIPHASH VECTORS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing sipHash() and SipHash against known answers" << endl;
+	OUTSTREAM << "---------------------------------------------------" << endl << endl;
+#ifdef HT_SIPHASH_VECTORS
+	try {
+		// Reference SipHash-2-4 outputs for the key 00 01 ... 0f and the messages 00 01 ... (n - 1).
+		const std::pair<size_t, uint64_t> reference[] = {
+			{0, 0x726fdb47dd0e0e31ULL}, {1, 0x74f839c593dc67fdULL}, {7, 0xab0200f58b01d137ULL},
+			{8, 0x93f5f5799a932462ULL}, {15, 0xa129ca6149be45e5ULL}, {63, 0x958a324ceb064572ULL}
+		};
+		unsigned char message[64];
+		for (size_t i = 0; i < sizeof(message); i++) {message[i] = static_cast<unsigned char>(i);}
+
+		OUTSTREAM << "Hashing the reference messages with sipHash<2, 4>()..." << endl;
+		bool ok = true;
+		for (const auto &[length, expected] : reference) {
+			ok &= (sipHash<2, 4>(message, length, 0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL) == expected);
+		}
+
+		// SipHash runs SipHash-1-3 under a key expanded from the seed; these pin its output for seed 42.
+		OUTSTREAM << "Hashing strings with SipHash(42)..." << endl;
+		const SipHash hash(42);
+		ok &= (hash("") == static_cast<size_t>(0x44ea81b8bd9cb39eULL));
+		ok &= (hash("a") == static_cast<size_t>(0xa9c4d8ae84e0a440ULL));
+		ok &= (hash("hash table") == static_cast<size_t>(0x10d7b8bfa631e7fbULL));
+		ok &= (hash("a key that is longer than sixteen bytes") == static_cast<size_t>(0x0224907d2e910bbbULL));
+		ok &= (hash(std::string(100, 'x')) == static_cast<size_t>(0xca46b2dc69004abeULL));
+		OUTSTREAM << (ok ? "SUCCESS: sipHash() and SipHash matched every known answer."
+				: "FAILURE: sipHash() or SipHash differed from a known answer.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST SIPHASH VECTORS ***" << endl << endl;
+#endif // HT_SIPHASH_VECTORS
+
+	/**	=====================================================================
+	 *	SIPHASH SEEDS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing that two SipHash tables get different seeds" << endl;
+	OUTSTREAM << "---------------------------------------------------" << endl << endl;
+#ifdef HT_SIPHASH_SEEDS
+	try {
+		using SipTable = Hashtable_t<std::string, size_t, SipHash>;
+		SipTable first;
+		SipTable second;
+
+		OUTSTREAM << "Inserting the same 64 keys into two default-constructed tables..." << endl;
+		for (size_t i = 0; i < 64; i++) {
+			first.insert("key" + std::to_string(i), i);
+			second.insert("key" + std::to_string(i), i);
+		}
+
+		// keys() lists the keys in bucket order, which only matches if both tables hash alike.
+		bool ok = (first.keys() != second.keys());
+		ok &= (SipHash().seed() != SipHash().seed());
+		for (size_t i = 0; i < 64; i++) {
+			ok &= (first.get("key" + std::to_string(i)) == std::optional<size_t>(i));
+			ok &= (second.get("key" + std::to_string(i)) == std::optional<size_t>(i));
+		}
+		OUTSTREAM << (ok ? "SUCCESS: the tables placed the keys differently and both found every key."
+				: "FAILURE: the tables hashed alike or lost a key.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST SIPHASH SEEDS ***" << endl << endl;
+#endif // HT_SIPHASH_SEEDS
+
+	/**	=====================================================================
+	 *	HASH VECTORS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing Crc32cHash, WyHash and AesHash against known answers" << endl;
+	OUTSTREAM << "-------------------------------------------------------------" << endl << endl;
+#ifdef HT_HASH_VECTORS
+	try {
+		const std::string keys[] = {"", "a", "hash table", "a key that is longer than sixteen bytes", std::string(100, 'x')};
+
+		// 0xe3069283 is the standard CRC32C check value of "123456789".
+		OUTSTREAM << "Checking crc32c() on the standard check string, and the SSE4.2 path against the portable one..." << endl;
+		bool ok = (crc32c("123456789", 9) == 0xe3069283U) && (crc32cPortable("123456789", 9, 0) == 0xe3069283U);
+		const std::string bytes(100, '\x5a');
+		for (size_t length = 0; length <= bytes.size(); length++) {
+			ok &= (crc32c(bytes.data(), length) == crc32cPortable(bytes.data(), length, 0));
+		}
+		for (const std::string &key : keys) {
+			ok &= (Crc32cHash()(key) == static_cast<size_t>(static_cast<uint64_t>(crc32c(key.data(), key.size())) * 0x9e3779b97f4a7c15ULL));
+		}
+
+		// WyHash has no reference vectors of its own; these pin its output for seed 42.
+		OUTSTREAM << "Hashing strings with WyHash(42)..." << endl;
+		const uint64_t wyExpected[] = {0x2ac44db3deb05300ULL, 0x30dbb7b7a902ea66ULL, 0xe0a0e21aa71d9e43ULL, 0x62cba843dd8aa7efULL, 0x290059d27a8c1f85ULL};
+		for (size_t i = 0; i < std::size(keys); i++) {
+			ok &= (WyHash(42)(keys[i]) == static_cast<size_t>(wyExpected[i]));
+		}
+
+		// AesHash takes the AES-NI path where the CPU has it, and falls back to wyHash with the same seed elsewhere.
+#if defined(HASHTABLE_X86_DISPATCH) && defined(__x86_64__)
+		const bool aesNi = cpuHasAes();
+#else
+		const bool aesNi = false;
+#endif
+		OUTSTREAM << "Hashing strings with AesHash(42), " << (aesNi ? "with" : "without") << " AES-NI..." << endl;
+		const uint64_t aesExpected[] = {0x61853fe765446160ULL, 0x7f1e3579af3ba260ULL, 0x31f23fdc300a3fa0ULL, 0x2537cab0f025a10aULL, 0xc1a8672acdb71ed5ULL};
+		for (size_t i = 0; i < std::size(keys); i++) {
+			ok &= (AesHash(42)(keys[i]) == static_cast<size_t>(aesNi ? aesExpected[i] : wyExpected[i]));
+		}
+		OUTSTREAM << (ok ? "SUCCESS: Crc32cHash, WyHash and AesHash matched every known answer."
+				: "FAILURE: Crc32cHash, WyHash or AesHash differed from a known answer.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST HASH VECTORS ***" << endl << endl;
+#endif // HT_HASH_VECTORS
+
+	/**	=====================================================================
+	 *	UPSERT / FETCH_ADD across a resize
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing upsert() and fetch_add() when the insert crosses the max load factor" << endl;
+	OUTSTREAM << "-----------------------------------------------------------------------------" << endl << endl;
+#ifdef HT_UPSERT_RESIZE
+	try {
+		HashTable ht1;
+		ht1.max_load_factor(0.5);
+		constexpr size_t KEYS = 2000;
+		auto key = [](size_t i) {return "counter:" + std::to_string(i);};
+
+		// Each call writes through the bucket it got back, so a bucket left behind by a resize loses the write.
+		OUTSTREAM << "Adding " << KEYS << " keys with upsert() and " << KEYS << " more with fetch_add()..." << endl;
+		bool ok = true;
+		size_t upsertResizes = 0, fetchAddResizes = 0;
+		for (size_t i = 0; i < KEYS; i++) {
+			const size_t capacity = ht1.capacity();
+			ok &= ht1.upsert(key(i), [i](size_t &value) {value = i + 1;});
+			upsertResizes += (ht1.capacity() != capacity);
+		}
+		for (size_t i = KEYS; i < 2 * KEYS; i++) {
+			const size_t capacity = ht1.capacity();
+			ok &= (ht1.fetch_add(key(i), i + 1) == 0);
+			fetchAddResizes += (ht1.capacity() != capacity);
+		}
+
+		ok &= (ht1.size() == 2 * KEYS);
+		for (size_t i = 0; i < 2 * KEYS; i++) {
+			ok &= (ht1.get(key(i)) == std::optional<size_t>(i + 1));
+		}
+		OUTSTREAM << "  resizes during upsert() = " << upsertResizes << ", during fetch_add() = " << fetchAddResizes << endl;
+		ok &= (upsertResizes > 0) && (fetchAddResizes > 0);
+		OUTSTREAM << (ok ? "SUCCESS: every write through a resizing upsert() or fetch_add() reached the table."
+				: "FAILURE: a write through a resizing upsert() or fetch_add() was lost.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST UPSERT RESIZE ***" << endl << endl;
+#endif // HT_UPSERT_RESIZE
+
+	/**	=====================================================================
+	 *	reserve / rehash / max_load_factor
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing reserve(), rehash() and max_load_factor()" << endl;
+	OUTSTREAM << "-------------------------------------------------" << endl << endl;
+#ifdef HT_LOAD_FACTOR
+	try {
+		HashTable ht1;
+		constexpr size_t KEYS = 1000;
+		auto key = [](size_t i) {return "load:" + std::to_string(i);};
+		auto allFound = [&ht1, &key](size_t count) {
+			bool found = (ht1.size() == count);
+			for (size_t i = 0; i < count; i++) {found &= (ht1.get(key(i)) == std::optional<size_t>(i));}
+			return found;
+		};
+
+		OUTSTREAM << "Reserving room for " << KEYS << " keys, then inserting them..." << endl;
+		ht1.reserve(KEYS);
+		const size_t reserved = ht1.capacity();
+		bool ok = (static_cast<double>(KEYS) < ht1.max_load_factor() * static_cast<double>(reserved));
+		for (size_t i = 0; i < KEYS; i++) {
+			ht1.insert(key(i), i);
+		}
+		ok &= (ht1.capacity() == reserved) && allFound(KEYS);
+		ht1.reserve(10);
+		ok &= (ht1.capacity() == reserved);
+		OUTSTREAM << "  capacity() = " << reserved << " after reserve(" << KEYS << ") and the inserts" << endl;
+
+		OUTSTREAM << "Rehashing to at least " << 8 * KEYS << " buckets, then to the fewest that fit..." << endl;
+		ht1.rehash(8 * KEYS);
+		ok &= (ht1.capacity() >= 8 * KEYS) && allFound(KEYS);
+		ht1.rehash(0);
+		ok &= (ht1.capacity() < 8 * KEYS) && (ht1.alpha() < ht1.max_load_factor()) && allFound(KEYS);
+
+		OUTSTREAM << "Raising the max load factor to 0.9, then lowering it to 0.25..." << endl;
+		ht1.max_load_factor(0.9);
+		ok &= (ht1.max_load_factor() == 0.9);
+		ht1.max_load_factor(0.25);
+		ok &= (ht1.max_load_factor() == 0.25) && (ht1.alpha() < 0.25) && allFound(KEYS);
+
+		OUTSTREAM << "Setting max load factors of 0 and 1, which must throw..." << endl;
+		for (double invalid : {0.0, 1.0}) {
+			try {
+				ht1.max_load_factor(invalid);
+				ok = false;
+			} catch (const std::invalid_argument &) {}
+		}
+		ok &= (ht1.max_load_factor() == 0.25);
+
+		OUTSTREAM << "Inserting " << KEYS << " more keys, checking the load after each..." << endl;
+		for (size_t i = KEYS; i < 2 * KEYS; i++) {
+			ht1.insert(key(i), i);
+			ok &= (ht1.alpha() < 0.25);
+		}
+		ok &= allFound(2 * KEYS);
+		OUTSTREAM << (ok ? "SUCCESS: reserve(), rehash() and max_load_factor() kept their guarantees."
+				: "FAILURE: reserve(), rehash() or max_load_factor() broke a guarantee.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST LOAD FACTOR ***" << endl << endl;
+#endif // HT_LOAD_FACTOR
+
+	/**	=====================================================================
+	 *	TOMBSTONE CHURN
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing remove()/insert() churn against tombstone build-up" << endl;
+	OUTSTREAM << "----------------------------------------------------------" << endl << endl;
+#ifdef HT_TOMBSTONE_CHURN
+	try {
+		HashTable ht1;
+		constexpr size_t LIVE = 64;
+		constexpr size_t CYCLES = 100000;
+		auto key = [](size_t i) {return "churn:" + std::to_string(i);};
+
+		// With room for four times the live keys, only tombstones can push the table to its max load factor.
+		OUTSTREAM << "Reserving room for " << 4 * LIVE << " keys and inserting " << LIVE << "..." << endl;
+		ht1.reserve(4 * LIVE);
+		for (size_t i = 0; i < LIVE; i++) {
+			ht1.insert(key(i), i);
+		}
+		const size_t capacity = ht1.capacity();
+
+		// Every removal may leave a tombstone; without rebuilds they would fill every empty bucket and the next miss would never end.
+		OUTSTREAM << "Replacing the oldest key with a new one " << CYCLES << " times..." << endl;
+		bool ok = true;
+		size_t rebuilds = 0, peakTombstones = 0;
+		for (size_t i = LIVE; i < LIVE + CYCLES; i++) {
+			ht1.remove(key(i - LIVE));
+			const size_t tombstones = ht1.tombstoneCount();
+			ht1.insert(key(i), i);
+			rebuilds += (ht1.tombstoneCount() + 1 < tombstones);
+			peakTombstones = std::max(peakTombstones, ht1.tombstoneCount());
+			ok &= (static_cast<double>(ht1.size() + ht1.tombstoneCount()) < ht1.max_load_factor() * static_cast<double>(ht1.capacity()));
+		}
+
+		ok &= (ht1.size() == LIVE) && (ht1.capacity() == capacity) && !ht1.contains(key(0));
+		for (size_t i = CYCLES; i < LIVE + CYCLES; i++) {
+			ok &= (ht1.get(key(i)) == std::optional<size_t>(i));
+		}
+		OUTSTREAM << "  rebuilds = " << rebuilds << ", peak tombstoneCount() = " << peakTombstones << ", capacity() = " << ht1.capacity() << endl;
+		ok &= (rebuilds > 0 || peakTombstones == 0);
+		OUTSTREAM << (ok ? "SUCCESS: rebuilds cleared the tombstones and the churn finished with every live key."
+				: "FAILURE: tombstones piled up, the table grew, or live keys were lost.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST TOMBSTONE CHURN ***" << endl << endl;
+#endif // HT_TOMBSTONE_CHURN
+
+	/**	=====================================================================
+	 *	get_many / contains_many
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing get_many() and contains_many() against get()" << endl;
+	OUTSTREAM << "----------------------------------------------------" << endl << endl;
+#ifdef HT_BATCHED_LOOKUP
+	try {
+		HashTable ht1;
+		constexpr size_t KEYS = 200;
+		std::vector<std::string> keyStore;
+		for (size_t i = 0; i < 2 * KEYS; i++) {
+			// Every third key is too long to be stored inline; the odd ones are never inserted.
+			keyStore.push_back(((i % 3 == 0) ? "a-batched-lookup-key:" : "b:") + std::to_string(i));
+			if (i % 2 == 0) {ht1.insert(keyStore.back(), i);}
+		}
+		const std::vector<std::string_view> queries(keyStore.begin(), keyStore.end());
+
+		// Whole batches, a partial last batch, and fewer keys than one batch.
+		const size_t counts[] = {0, 1, PREFETCH_BATCH - 1, PREFETCH_BATCH, PREFETCH_BATCH + 1, 3 * PREFETCH_BATCH + 5, queries.size()};
+		OUTSTREAM << "Looking up batches of 0 to " << queries.size() << " keys, half of them missing..." << endl;
+		bool ok = true;
+		for (size_t count : counts) {
+			const std::span<const std::string_view> batch(queries.data(), count);
+			std::vector<std::optional<size_t>> values(count + 1, std::optional<size_t>(KEYS * 10));
+			std::unique_ptr<bool[]> found(new bool[count + 1]);
+			found[count] = true;
+			ht1.get_many(batch, values);
+			ht1.contains_many(batch, std::span<bool>(found.get(), count + 1));
+			for (size_t i = 0; i < count; i++) {
+				ok &= (values[i] == ht1.get(keyStore[i])) && (found[i] == ht1.contains(keyStore[i]));
+			}
+			// The results past the last key are left alone.
+			ok &= (values[count] == std::optional<size_t>(KEYS * 10)) && found[count];
+		}
+
+		OUTSTREAM << "Passing result spans one entry short, which must throw..." << endl;
+		const std::span<const std::string_view> batch(queries.data(), PREFETCH_BATCH + 1);
+		std::vector<std::optional<size_t>> values(PREFETCH_BATCH);
+		std::unique_ptr<bool[]> found(new bool[PREFETCH_BATCH]);
+		try {
+			ht1.get_many(batch, values);
+			ok = false;
+		} catch (const std::invalid_argument &) {}
+		try {
+			ht1.contains_many(batch, std::span<bool>(found.get(), PREFETCH_BATCH));
+			ok = false;
+		} catch (const std::invalid_argument &) {}
+		OUTSTREAM << (ok ? "SUCCESS: get_many() and contains_many() matched get() and refused short result spans."
+				: "FAILURE: get_many() or contains_many() differed from get() or accepted a short result span.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST BATCHED LOOKUP ***" << endl << endl;
+#endif // HT_BATCHED_LOOKUP
+
+	/**	=====================================================================
+	 *	LOADER
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing loadKeyValueFile() on CRLF, malformed and very long lines" << endl;
+	OUTSTREAM << "-----------------------------------------------------------------" << endl << endl;
+#ifdef HT_LOADER
+	try {
+		const std::string loadPath = (std::filesystem::temp_directory_path() / "HashTableTests.csv").string();
+		const std::string longKey(100000, 'k');
+		{
+			std::ofstream out(loadPath, std::ios::binary);
+			out << "alpha,1\r\n" << "beta,2\r\n" << "\r\n" << "gamma,with,commas,3\r\n";
+			// Lines 5 to 7 do not parse: no separator, a value with trailing junk, and no value.
+			out << "no separator\r\n" << "delta,12x\r\n" << "epsilon,\r\n";
+			out << longKey << ",4\r\n";
+			// Line 9 is longer than a block, so it cannot be parsed and is skipped to its end.
+			out << std::string(BLOCK_SIZE + 1000, 'x') << ",5\n";
+			out << "alpha,7\n" << "zeta,6";
+		}
+
+		OUTSTREAM << "Loading a file of 11 lines, one of them longer than a block..." << endl;
+		HashTable ht1;
+		const LoadStats stats = loadKeyValueFile(ht1, loadPath);
+		OUTSTREAM << "  rows = " << stats.rows << ", new keys = " << stats.newKeys << ", malformed rows = " << stats.malformedRows
+				<< " (first on line " << stats.firstMalformedLine << ")" << endl;
+		bool ok = (stats.rows == 6) && (stats.newKeys == 5) && (stats.malformedRows == 4) && (stats.firstMalformedLine == 5);
+		ok &= (stats.bytes == std::filesystem::file_size(loadPath)) && (ht1.size() == 5);
+		ok &= (ht1.get("alpha") == std::optional<size_t>(7)) && (ht1.get("beta") == std::optional<size_t>(2));
+		ok &= (ht1.get("gamma,with,commas") == std::optional<size_t>(3)) && (ht1.get(longKey) == std::optional<size_t>(4));
+		ok &= (ht1.get("zeta") == std::optional<size_t>(6)) && !ht1.contains("delta") && !ht1.contains("epsilon");
+		std::filesystem::remove(loadPath);
+		OUTSTREAM << (ok ? "SUCCESS: the loader read every good line and skipped every malformed one."
+				: "FAILURE: the loader misread a line or miscounted the rows.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST LOADER ***" << endl << endl;
+#endif // HT_LOADER
+
+	/**	=====================================================================
+	 *	STATS
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing HashTable::stats() on small known tables" << endl;
+	OUTSTREAM << "------------------------------------------------" << endl << endl;
+#ifdef HT_STATS
+	try {
+		OUTSTREAM << "Taking stats() of a table with a single key..." << endl;
+		HashTable single(16);
+		single.insert("only", 1);
+		HashTableStats stats = single.stats();
+		bool ok = (stats.capacity == single.capacity()) && (stats.size == 1) && (stats.tombstones == 0) && (stats.empty == single.capacity() - 1);
+		ok &= (stats.loadFactor == 1.0 / static_cast<double>(single.capacity()));
+		ok &= (stats.hitProbes.samples == 1) && (stats.hitProbes.max == 1) && (stats.hitProbes.mean == 1.0);
+		ok &= (stats.clusters.samples == 1) && (stats.clusters.max == 1);
+		// A miss ends on its home bucket, or on the next probe if the home bucket holds the key.
+		ok &= (stats.missProbes.samples == HashTableStats::MISS_SAMPLES) && (stats.missProbes.histogram[0] == 0) && (stats.missProbes.max <= 2);
+		ok &= (stats.bucketBytes == single.capacity() * sizeof(HashTableBucket)) && (stats.keyArenaUsedBytes == 0);
+
+		OUTSTREAM << "Taking stats() after 5 inserts and 2 removals..." << endl;
+		HashTable ht1(16);
+		const std::string keys[] = {"one", "two", "three", "four", "five"};
+		for (size_t i = 0; i < std::size(keys); i++) {
+			ht1.insert(keys[i], i);
+		}
+		ht1.remove("two");
+		ht1.remove("four");
+		stats = ht1.stats();
+		OUTSTREAM << stats;
+
+		ok &= (stats.capacity == ht1.capacity()) && (stats.size == 3) && (stats.tombstones == ht1.tombstoneCount());
+		ok &= (stats.empty == ht1.capacity() - 3 - ht1.tombstoneCount()) && (stats.loadFactor == ht1.alpha());
+		// Every live key is one hit sample, of the length a lookup of it probes.
+		size_t probeTotal = 0, probeMax = 0;
+		for (const std::string &key : {keys[0], keys[2], keys[4]}) {
+			probeTotal += ht1.probeLength(key);
+			probeMax = std::max(probeMax, ht1.probeLength(key));
+		}
+		ok &= (stats.hitProbes.samples == 3) && (stats.hitProbes.mean == static_cast<double>(probeTotal) / 3.0) && (stats.hitProbes.max == probeMax);
+		// Every live bucket and tombstone lies in exactly one cluster.
+		size_t clustered = 0;
+		for (size_t length = 0; length < stats.clusters.histogram.size(); length++) {
+			clustered += length * stats.clusters.histogram[length];
+		}
+		ok &= (clustered == 3 + ht1.tombstoneCount());
+		ok &= (stats.missProbes.samples == HashTableStats::MISS_SAMPLES) && (stats.missProbes.histogram[0] == 0);
+		ok &= !HASHTABLE_STATS_ENABLED || (stats.resizes == 0);
+		OUTSTREAM << (ok ? "SUCCESS: stats() counted the buckets, probes and clusters of both tables."
+				: "FAILURE: stats() miscounted the buckets, probes or clusters.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST STATS ***" << endl << endl;
+#endif // HT_STATS
+
+	/**	=====================================================================
+	 *	EQUAL HASHES
+	 *	=====================================================================	*/
+	OUTSTREAM << "Testing lookups of keys with equal hash codes but different bytes" << endl;
+	OUTSTREAM << "-----------------------------------------------------------------" << endl << endl;
+#ifdef HT_EQUAL_HASHES
+	try {
+		constexpr size_t KEYS = 200;
+		// Keys of one length that differ in one byte, prefixes of each other, and keys too long to be stored inline.
+		auto key = [](size_t i) {
+			if (i % 3 == 0) {return "collide:" + std::to_string(1000 + i);}
+			if (i % 3 == 1) {return std::string(i / 3 + 1, 'p');}
+			return "a-colliding-key-too-long-to-inline:" + std::to_string(i);
+		};
+		auto check = [&key](auto table) {
+			bool found = true;
+			for (size_t i = 0; i < KEYS; i++) {found &= table.insert(key(i), i);}
+			for (size_t i = 0; i < KEYS; i++) {found &= !table.insert(key(i), i);}
+			found &= (table.size() == KEYS) && !table.contains("collide:999") && !table.contains("") && !table.contains(std::string(KEYS, 'p'));
+
+			for (size_t i = 0; i < KEYS; i += 2) {found &= table.remove(key(i));}
+			for (size_t i = 0; i < KEYS; i++) {
+				found &= (table.get(key(i)) == ((i % 2 == 0) ? std::nullopt : std::optional<size_t>(i)));
+			}
+			for (size_t i = 0; i < KEYS; i += 2) {found &= table.insert(key(i), i + KEYS);}
+			for (size_t i = 0; i < KEYS; i++) {
+				found &= (table.get(key(i)) == std::optional<size_t>((i % 2 == 0) ? i + KEYS : i));
+			}
+			return found && (table.size() == KEYS);
+		};
+
+		OUTSTREAM << "Inserting, removing and looking up " << KEYS << " keys that all hash to 42..." << endl;
+		bool ok = check(Hashtable_t<std::string, size_t, CollidingHash>());
+		ok &= check(FlatHashtable_t<std::string, size_t, CollidingHash>());
+		ok &= check(IncrementalHashtable_t<std::string, size_t, CollidingHash>());
+		OUTSTREAM << (ok ? "SUCCESS: every table told the colliding keys apart by their bytes."
+				: "FAILURE: a table confused two keys with equal hash codes.")
+				<< endl << endl;
+	} catch (exception& e) {
+		OUTSTREAM << "Exception: " << e.what() << endl << endl;
+	}
+#else
+	OUTSTREAM << "*** DID NOT TEST EQUAL HASHES ***" << endl << endl;
+#endif // HT_EQUAL_HASHES
+
 	OUTSTREAM << "All tests complete." << endl;
 	return 0;
 }